@@ -0,0 +1,106 @@
+/*
+ * active_object.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef ACTIVE_OBJECT_H_
+#define ACTIVE_OBJECT_H_
+#include "common.h"
+#include "lf_queue.h"
+#include "mem_pool.h"
+
+/*
+ * Active objects: each object is a kernel task which owns an event queue and a dispatch function. The task
+ * sleeps in task_wait_notify() while its queue is empty and runs dispatch() to completion for every event,
+ * so there are no polling ticks and no context switches without work.
+ *
+ * Events are allocated from memory pools and reference counted: one event can be posted to several objects
+ * and is returned to its pool after the last object handled it. Events with pool == NULL are static (may be
+ * const) and are never counted or freed. Posting and publishing never block and can be called from ISRs.
+ *
+ * Usage:
+ *     static void blinky_dispatch(active_object_t *me, const ao_event_t *e) { switch (e->sig) { ... } }
+ *     ACTIVE_OBJECT_DEFINE(blinky, 8, blinky_dispatch);
+ * and add X(blinky_task, CONFIG_TASK_STACK_SIZE_B) to CONFIG_USER_TASKS. The first event every object gets is
+ * AO_SIG_INIT, delivered in the object's own task.
+ */
+
+#define AO_MAX_SIGNALS CONFIG_AO_MAX_SIGNALS		// Signals which can be published (subscription table size)
+
+// Reserved signals, user signals start from AO_SIG_USER:
+enum {
+	AO_SIG_INIT = 0,
+	AO_SIG_USER
+};
+
+typedef struct ao_event_ {
+	uint16_t			sig;
+	uint16_t			reserved;
+	volatile uint32_t	ref_count;	// number of queues holding the event
+	mem_pool_t *		pool;		// pool to return the event to, NULL for static events
+} ao_event_t;
+
+typedef struct active_object_ active_object_t;
+typedef void (*ao_dispatch_t)(active_object_t *me, const ao_event_t *e);
+
+struct active_object_ {
+	lf_mpmc_t *			queue;		// of const ao_event_t *
+	ao_dispatch_t		dispatch;	// handles one event, must not block
+	uint32_t			task_id;
+	uint32_t			dropped;	// events not posted because the queue was full
+};
+
+/**
+ * @brief Define active object "name" with event queue of "queue_len" (power of 2) events and its task
+ *        handler name##_task, which must be added to CONFIG_USER_TASKS.
+ */
+#define ACTIVE_OBJECT_DEFINE(name, queue_len, dispatch_fn) \
+	LF_MPMC_DEFINE(name##_queue, queue_len); \
+	active_object_t name = { &name##_queue, (dispatch_fn), name##_task_id, 0 }; \
+	void name##_task(void) { ao_run(&name); }
+
+/**
+ * @brief Initializer of a static event: static const ao_event_t tick_evt = AO_STATIC_EVENT(SIG_TICK);
+ */
+#define AO_STATIC_EVENT(sig_) { .sig = (sig_), .ref_count = 0, .pool = NULL }
+
+/* ================== Active object user API ================================== */
+/**
+ * @brief     Allocate event from the pool. Pool block size must be at least the size of the user event
+ *            structure which embeds ao_event_t as the first member. Can be called from ISR.
+ * @return    event or NULL if the pool is empty.
+ */
+ao_event_t *ao_event_new(mem_pool_t *pool, uint16_t sig);
+
+/**
+ * @brief     Post event to the object queue. Doesn't block, can be called from ISR.
+ *            Event allocated by ao_event_new() and not posted anywhere is freed if posting fails.
+ * @return    0 on success, -1 if the queue is full.
+ */
+int ao_post(active_object_t *ao, const ao_event_t *e);
+
+/**
+ * @brief     Subscribe object to a signal delivered by ao_publish().
+ */
+void ao_subscribe(active_object_t *ao, uint16_t sig);
+
+/**
+ * @brief     Unsubscribe object from a signal.
+ */
+void ao_unsubscribe(active_object_t *ao, uint16_t sig);
+
+/**
+ * @brief     Post event to all objects subscribed to its signal. Doesn't block, can be called from ISR.
+ *            Event allocated by ao_event_new() is freed if there are no subscribers.
+ * @return    number of objects the event was posted to.
+ */
+uint32_t ao_publish(const ao_event_t *e);
+
+/**
+ * @brief     Body of the active object task: dispatches events, sleeps while the queue is empty.
+ */
+void ao_run(active_object_t *ao);
+
+#endif /* ACTIVE_OBJECT_H_ */
@@ -0,0 +1,173 @@
+/*
+ * atomic.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ *
+ * Lock-free primitives on Cortex-M4 exclusive access instructions (LDREX/STREX). Interrupts are never masked:
+ * if an exception happens between LDREX and STREX, the exclusive monitor is cleared on exception entry/return,
+ * STREX fails and the operation is retried. All operations are safe between tasks and ISRs.
+ * On host (scheduling simulator) the same API is implemented with GCC __atomic builtins.
+ */
+
+#ifndef ATOMIC_H_
+#define ATOMIC_H_
+#include <stdint.h>
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+
+static inline uint32_t atomic_ldrex(volatile uint32_t *addr)
+{
+	uint32_t val;
+	__asm volatile ("LDREX %0, [%1]" : "=r" (val) : "r" (addr) : "memory");
+	return val;
+}
+
+/* Returns 0 if store succeeded */
+static inline uint32_t atomic_strex(volatile uint32_t *addr, uint32_t val)
+{
+	uint32_t failed;
+	__asm volatile ("STREX %0, %2, [%1]" : "=&r" (failed) : "r" (addr), "r" (val) : "memory");
+	return failed;
+}
+
+static inline void atomic_clrex(void)
+{
+	__asm volatile ("CLREX" ::: "memory");
+}
+
+/**
+ * @brief Memory barrier: all memory accesses before it complete before any access after it.
+ */
+static inline void atomic_barrier(void)
+{
+	__asm volatile ("DMB" ::: "memory");
+}
+
+/**
+ * @brief  Atomically add value.
+ * @return new value
+ */
+static inline uint32_t atomic_add(volatile uint32_t *addr, uint32_t val)
+{
+	uint32_t new_val;
+	do {
+		new_val = atomic_ldrex(addr) + val;
+	} while (atomic_strex(addr, new_val));
+	return new_val;
+}
+
+/**
+ * @brief  Atomically replace value with "desired" if it equals to "expected".
+ * @return 1 if value was replaced, 0 otherwise.
+ */
+static inline uint32_t atomic_cas(volatile uint32_t *addr, uint32_t expected, uint32_t desired)
+{
+	do {
+		if (atomic_ldrex(addr) != expected) {
+			atomic_clrex();
+			return 0;
+		}
+	} while (atomic_strex(addr, desired));
+	return 1;
+}
+
+/**
+ * @brief  Atomically replace value.
+ * @return previous value
+ */
+static inline uint32_t atomic_swap(volatile uint32_t *addr, uint32_t val)
+{
+	uint32_t old;
+	do {
+		old = atomic_ldrex(addr);
+	} while (atomic_strex(addr, val));
+	return old;
+}
+
+/**
+ * @brief  Atomically set bits of the mask.
+ * @return previous value
+ */
+static inline uint32_t atomic_set_bits(volatile uint32_t *addr, uint32_t mask)
+{
+	uint32_t old;
+	do {
+		old = atomic_ldrex(addr);
+	} while (atomic_strex(addr, old | mask));
+	return old;
+}
+
+/**
+ * @brief  Atomically clear bits of the mask.
+ * @return previous value
+ */
+static inline uint32_t atomic_clear_bits(volatile uint32_t *addr, uint32_t mask)
+{
+	uint32_t old;
+	do {
+		old = atomic_ldrex(addr);
+	} while (atomic_strex(addr, old & ~mask));
+	return old;
+}
+
+#else /* host build */
+
+static inline void atomic_barrier(void)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t atomic_add(volatile uint32_t *addr, uint32_t val)
+{
+	return __atomic_add_fetch(addr, val, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t atomic_cas(volatile uint32_t *addr, uint32_t expected, uint32_t desired)
+{
+	return __atomic_compare_exchange_n(addr, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t atomic_swap(volatile uint32_t *addr, uint32_t val)
+{
+	return __atomic_exchange_n(addr, val, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t atomic_set_bits(volatile uint32_t *addr, uint32_t mask)
+{
+	return __atomic_fetch_or(addr, mask, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t atomic_clear_bits(volatile uint32_t *addr, uint32_t mask)
+{
+	return __atomic_fetch_and(addr, ~mask, __ATOMIC_SEQ_CST);
+}
+
+#endif /* __ARM_ARCH_7M__ || __ARM_ARCH_7EM__ */
+
+/**
+ * @brief  Atomically subtract value.
+ * @return new value
+ */
+static inline uint32_t atomic_sub(volatile uint32_t *addr, uint32_t val)
+{
+	return atomic_add(addr, -val);
+}
+
+/**
+ * @brief  Aligned 32-bit loads and stores are single instructions, so they are atomic. Barrier keeps order.
+ */
+static inline uint32_t atomic_load(const volatile uint32_t *addr)
+{
+	uint32_t val = *addr;
+	atomic_barrier();
+	return val;
+}
+
+static inline void atomic_store(volatile uint32_t *addr, uint32_t val)
+{
+	atomic_barrier();
+	*addr = val;
+}
+
+#endif /* ATOMIC_H_ */
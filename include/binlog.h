@@ -0,0 +1,78 @@
+/*
+ * binlog.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef BINLOG_H_
+#define BINLOG_H_
+#include "common.h"
+
+/*
+ * Deferred formatting logger. LOG(fmt, args...) stores only the address of the format string and the raw
+ * argument words into a record of the binlog_buffer ring, nothing is formatted on the target. Format strings go to
+ * the .logstr section which is kept in the ELF but not loaded (no flash), tools/binlog/binlog_decode.py dumps the
+ * ring over GDB/OpenOCD and prints the messages with the strings from build/scheduler.elf ("make log").
+ * A call is an atomic increment and a few stores, safe from tasks and ISRs. The ring keeps the latest
+ * BINLOG_RECORDS messages. Arguments are up to BINLOG_MAX_ARGS 32-bit values: integers, characters and pointers;
+ * %s is printed if it points to a string of the image (flash or SRAM copy of .data), no doubles or 64-bit values.
+ * Without CONFIG_BINLOG, LOG() is printf() of the message and a newline.
+ */
+
+#define BINLOG_MAGIC (0x474F4C42U)			// "BLOG", checked by the host script
+#define BINLOG_RECORDS CONFIG_BINLOG_RECORDS	// power of 2
+#define BINLOG_MAX_ARGS (5U)
+
+// Layout is read by the host script, change both together:
+typedef struct binlog_record_ {
+	volatile uint32_t	seq;			// sequence number + 1, 0 while the record is written
+	uint32_t			fmt;			// address of the format string in .logstr
+	uint32_t			timestamp;		// microseconds with CONFIG_HR_TIMEBASE, otherwise scheduler ticks
+	uint32_t			args[BINLOG_MAX_ARGS];
+} binlog_record_t;
+
+typedef struct binlog_buffer_ {
+	uint32_t			magic;
+	uint32_t			n_records;
+	uint32_t			timestamp_hz;
+	volatile uint32_t	head;			// sequence number of the next record
+	binlog_record_t		records[BINLOG_RECORDS];
+} binlog_buffer_t;
+
+#if CONFIG_BINLOG
+extern binlog_buffer_t binlog_buffer;
+
+/**
+ * @brief     Store one record. Called by LOG(). Can be called from ISR.
+ * @param[in] words - format string address followed by the arguments.
+ * @param[in] n_words - 1 + number of arguments.
+ */
+void binlog_write(const uint32_t *words, uint32_t n_words);
+
+// Number of arguments (0 .. 5) and cast of every argument to a 32-bit word:
+#define BINLOG_NARGS(...) BINLOG_NARGS_(0, ##__VA_ARGS__, 5, 4, 3, 2, 1, 0)
+#define BINLOG_NARGS_(_0, _1, _2, _3, _4, _5, n, ...) n
+#define BINLOG_CAT(a, b) BINLOG_CAT_(a, b)
+#define BINLOG_CAT_(a, b) a##b
+#define BINLOG_WORDS_0()
+#define BINLOG_WORDS_1(a) , (uint32_t)(a)
+#define BINLOG_WORDS_2(a, ...) , (uint32_t)(a) BINLOG_WORDS_1(__VA_ARGS__)
+#define BINLOG_WORDS_3(a, ...) , (uint32_t)(a) BINLOG_WORDS_2(__VA_ARGS__)
+#define BINLOG_WORDS_4(a, ...) , (uint32_t)(a) BINLOG_WORDS_3(__VA_ARGS__)
+#define BINLOG_WORDS_5(a, ...) , (uint32_t)(a) BINLOG_WORDS_4(__VA_ARGS__)
+
+/**
+ * @brief     Log a message, "fmt" must be a string literal in printf syntax without trailing newline.
+ */
+#define LOG(fmt, ...) do { \
+		static const char binlog_fmt_[] __attribute__((section(".logstr"))) = fmt; \
+		const uint32_t binlog_words_[] = { (uint32_t)binlog_fmt_ \
+				BINLOG_CAT(BINLOG_WORDS_, BINLOG_NARGS(__VA_ARGS__))(__VA_ARGS__) }; \
+		binlog_write(binlog_words_, ARRAY_SIZE(binlog_words_)); \
+	} while (0)
+#else
+#define LOG(fmt, ...) printf(fmt "\n", ##__VA_ARGS__)
+#endif /* CONFIG_BINLOG */
+
+#endif /* BINLOG_H_ */
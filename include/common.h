@@ -19,34 +19,115 @@ typedef unsigned short uint16_t;
 typedef unsigned char uint8_t;
 #endif*/ /* NOSTD */
 
-#define MAX_TASKS (4 + 1) 				// 4 User tasks + 1 Idle
-#define IDLE_TASK_ID (0)
+#include "kernel_config.h"
 
-#define TASK_STACK_SIZE_B (1024U)
-#define SCHEDULER_STACK_SIZE_B (1024U * 2U)
-#define TASK_DURATION (1000) // us
+// Put function into SRAM (.ramfunc is copied with .data at startup): it keeps running while flash is erased
+#define RAMFUNC __attribute__((section(".ramfunc"), noinline))
+
+// Task ids are positions in KERNEL_TASK_LIST: <handler>_id. MAX_TASKS is the total number of tasks:
+#define TASK_ID_ENUM(entry, stack_size, ...) entry##_id,
+typedef enum {
+	KERNEL_TASK_LIST(TASK_ID_ENUM)
+	MAX_TASKS
+} task_id_t;
+
+#define IDLE_TASK_ID (task_idle_id)
+#define TIMER_TASK_ID (sw_timer_service_task_id)
+#define COROUTINE_TASK_ID (coroutine_runner_task_id)
+
+#define TASK_STACK_SIZE_B CONFIG_TASK_STACK_SIZE_B
+#define SCHEDULER_STACK_SIZE_B CONFIG_SCHEDULER_STACK_SIZE_B
 
 // Task definition:
 typedef void (*task_handler_t)(void);
 
 typedef enum {
 	TASK_READY,
-	TASK_BLOCKED
+	TASK_BLOCKED,		// Waits for block_count tick (delay_task), notifications don't wake it
+	TASK_WAITING,		// Waits for notification or block_count tick (task_wait_notify with timeout)
+	TASK_SUSPENDED,		// Waits for notification only
+	TASK_THROTTLED		// Used up its CPU budget, waits for replenishment (CONFIG_TASK_BUDGETS)
 } task_state_t;
 
+#if CONFIG_HW_COUNTERS
+// DWT counts accumulated while the task was running (including ISRs which interrupted it):
+typedef struct task_hw_counters_ {
+	uint64_t	cycles;		// CPU cycles
+} task_hw_counters_t;
+#endif
+
 typedef struct TCB_ {
 	uint32_t *		stack_start;
-	uint32_t 		current_state;
+	volatile uint32_t current_state;	// task_state_t, changed by ISRs with atomic.h
 	uint32_t 		block_count;
 	task_handler_t 	handler;
+	volatile uint32_t notify_pending;
+	uint8_t			priority;			// SCHED_POLICY_PRIORITY: higher value - higher priority
+	uint8_t			preempt_threshold;	// preempted only by priority above max(priority, preempt_threshold)
+	uint8_t			threshold_active;	// switched in and not blocked since then: threshold is in effect
+#if CONFIG_STACK_CHECK
+	uint32_t *		stack_limit;	// lowest address of the stack, holds STACK_CANARY
+#endif
+#if CONFIG_STATS
+	uint32_t		switch_count;	// how many times task was switched in
+#if CONFIG_HR_TIMEBASE
+	uint32_t		run_time_us;	// total running time
+#endif
+#endif
+#if CONFIG_HW_COUNTERS
+	task_hw_counters_t hw_counters;
+#endif
+#if CONFIG_TASK_BUDGETS
+	uint32_t		budget_us;			// CPU time per replenishment period, 0 - unlimited
+	uint32_t		budget_period;		// replenishment period in ticks
+	uint32_t		budget_used_us;		// charged in the current period
+	uint32_t		replenish_tick;		// start of the next period
+	uint32_t		budget_overruns;	// times the task was throttled (or fell back)
+	uint8_t			budget_fallback;	// SCHED_POLICY_PRIORITY: out of budget runs at fallback_priority
+	uint8_t			fallback_priority;
+	uint8_t			budget_priority;	// priority restored on replenishment
+	uint8_t			budget_demoted;		// runs at fallback_priority
+#endif
+#if CONFIG_ADMISSION_CONTROL
+	uint32_t		period_us;			// periodic task: release period, 0 - not analysed
+	uint32_t		wcet_us;			// worst-case execution time of one job
+	uint32_t		deadline_us;		// relative deadline, 0 - period
+	uint32_t		response_us;		// worst-case response time found by the admission test
+#endif
 } TCB_t;
 
+#if CONFIG_TASK_BUDGETS
+/*
+ * Task list attributes of an aperiodic server (deferrable server, SCHED_POLICY_PRIORITY): the task runs at
+ * "priority_" while it has budget, "capacity_us" every "period_ticks", and at "background_priority" after that
+ * till the next period, e.g. for the worker of a work queue:
+ *     X(io_workq_task, CONFIG_TASK_STACK_SIZE_B, APERIODIC_SERVER(2000, 10, 250, 1))
+ * Budget is replenished at period boundaries whether it was used or not, so tasks below "priority_" lose at most
+ * 2 x capacity_us to the server in one period (capacity at the end of a period, then at the start of the next).
+ */
+#define APERIODIC_SERVER(capacity_us, period_ticks, priority_, background_priority) \
+	.priority = (priority_), .budget_us = (capacity_us), .budget_period = (period_ticks), \
+	.budget_fallback = 1, .fallback_priority = (background_priority)
+#endif
+
+#if CONFIG_SCHED_POLICY == SCHED_POLICY_CYCLIC
+// Minor frame of the cyclic executive schedule table (generated cyclic_table.h):
+#define CYCLIC_JOB_START (1U << 0)	// next job of the task is released at the start of the frame
+#define CYCLIC_JOB_END (1U << 1)	// job must be done by the end of the frame, otherwise it is an overrun
+
+typedef struct cyclic_frame_ {
+	uint8_t		task_id;		// owner of the frame, IDLE_TASK_ID for a free frame
+	uint8_t		flags;
+} cyclic_frame_t;
+#endif
+
 
 // Basic delay values in scheduler ticks:
-#define DELAY_1S (1000U)			// means 1000 scheduler cycles delay
+#define DELAY_1S (CONFIG_TICK_RATE_HZ)	// scheduler ticks in 1 second
 #define DELAY_2S (DELAY_1S * 2)
 #define DELAY_4S (DELAY_1S * 4)
 #define DELAY_8S (DELAY_1S * 8)
+#define WAIT_FOREVER (0xFFFFFFFFU)	// Timeout value for task_wait_notify() without timeout
 
 #define ARRAY_SIZE(x) (sizeof(x)/ sizeof(*x))
 
@@ -0,0 +1,103 @@
+/*
+ * coroutine.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef COROUTINE_H_
+#define COROUTINE_H_
+#include "common.h"
+#include "scheduler.h"
+
+/*
+ * Stackless coroutines (protothreads). A coroutine is a function which is called again and again by the
+ * coroutine runner task and continues from the last await point (switch/case on the saved line number).
+ * All coroutines run on the stack of the runner task and cost only sizeof(coroutine_t) of RAM each.
+ *
+ * Limitations:
+ *  - local variables are NOT preserved across await points: keep state in a structure which embeds
+ *    coroutine_t (or is pointed by "arg");
+ *  - await macros can be used only in the coroutine function body itself, not in the functions it calls;
+ *  - "switch" can't be used in the coroutine function around await points.
+ */
+
+#define CO_WHEEL_SIZE CONFIG_CO_WHEEL_SIZE		// Delay wheel slots, must be power of 2
+
+typedef enum {
+	CO_YIELDED,			// Wants to run again on the next runner pass
+	CO_WAIT_DELAY,		// Sleeps till wake_tick
+	CO_WAIT_EVENT,		// Sleeps till event is signaled
+	CO_DONE				// Finished, will not be called anymore
+} co_state_t;
+
+typedef struct co_event_ co_event_t;
+typedef struct coroutine_ coroutine_t;
+typedef co_state_t (*coroutine_fn_t)(coroutine_t *co);
+
+struct coroutine_ {
+	uint16_t		line;		// resume point, 0 - start of the function
+	uint16_t		state;		// co_state_t
+	uint32_t		wake_tick;
+	co_event_t *	event;
+	coroutine_fn_t	fn;
+	void *			arg;
+	coroutine_t *	next;		// link in ready, delay wheel or event waiters list
+};
+
+struct co_event_ {
+	volatile uint32_t count;	// signals not consumed yet
+	coroutine_t *	waiters;
+};
+
+/* ================== Coroutine body macros ==================================== */
+#define CO_BEGIN(co) switch ((co)->line) { case 0:
+
+#define CO_END(co) } (co)->line = 0; return CO_DONE
+
+// Let other coroutines run, continue on the next runner pass:
+#define CO_YIELD(co) do { (co)->line = __LINE__; return CO_YIELDED; case __LINE__:; } while (0)
+
+// Sleep for "ticks" scheduler ticks:
+#define CO_DELAY(co, ticks) do { (co)->wake_tick = get_tick_count() + (ticks); (co)->line = __LINE__; \
+		return CO_WAIT_DELAY; case __LINE__:; } while (0)
+
+// Poll condition on every runner pass till it becomes true:
+#define CO_WAIT_UNTIL(co, cond) do { (co)->line = __LINE__; case __LINE__: if (!(cond)) return CO_YIELDED; } while (0)
+
+// Sleep till event is signaled, consumes one signal:
+#define CO_WAIT_EVENT(co, ev) do { (co)->event = (ev); (co)->line = __LINE__; case __LINE__: \
+		if (!co_event_take(ev)) return CO_WAIT_EVENT; } while (0)
+
+/* ================== Coroutine user API ======================================= */
+/**
+ * @brief     Start coroutine. Its function is first called from the runner task on the next runner pass.
+ * @param[in] co - coroutine descriptor, must stay valid till coroutine is done
+ * @param[in] fn - coroutine function
+ * @param[in] arg - user argument, available as co->arg
+ */
+void co_start(coroutine_t *co, coroutine_fn_t fn, void *arg);
+
+/**
+ * @brief     Initialize event with no pending signals.
+ */
+void co_event_init(co_event_t *ev);
+
+/**
+ * @brief     Signal event: wakes all coroutines waiting for it. Can be called from ISR and preemptive tasks.
+ */
+void co_event_signal(co_event_t *ev);
+
+/**
+ * @brief     Consume one pending signal, used by CO_WAIT_EVENT.
+ * @return    1 if signal was consumed, 0 if there were no signals.
+ */
+uint32_t co_event_take(co_event_t *ev);
+
+/* ================== Service API calls used by kernel: ======================= */
+/**
+ * @brief     Coroutine runner task. Runs all coroutines on its own stack.
+ */
+void coroutine_runner_task(void);
+
+#endif /* COROUTINE_H_ */
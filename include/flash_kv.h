@@ -0,0 +1,70 @@
+/*
+ * flash_kv.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef FLASH_KV_H_
+#define FLASH_KV_H_
+#include "common.h"
+
+/*
+ * Key-value store in flash sectors 10 and 11. The active sector is an append-only log of records
+ * {key, len, crc, value}; a newer record of a key overrides the older ones, a record with len 0 deletes the key.
+ * When the active sector is full, the current values are compacted into the other sector, which becomes active,
+ * so both sectors are erased in turn (wear levelling) and a power loss during compaction keeps the old sector.
+ *
+ * All values are cached in RAM: the cache is rebuilt from the log at boot and kv_get() is an O(1) copy which never
+ * touches flash. kv_put() only updates the cache; the kv_store_task writes changed keys to flash in batches,
+ * CONFIG_KV_FLUSH_DELAY_MS after the first change, so repeated writes of a key cost one flash record.
+ * Erase runs in the background task while other tasks keep running (see port/flash_if.h).
+ */
+
+#define KV_MAX_KEYS CONFIG_KV_MAX_KEYS
+#define KV_MAX_VALUE_B CONFIG_KV_MAX_VALUE_B
+
+/**
+ * @brief     Rebuild the RAM cache from flash. Called before scheduler start.
+ */
+void kv_init(void);
+
+/**
+ * @brief     Set value of the key. Doesn't touch flash, doesn't block, can be called from ISR.
+ * @param[in] key - 0 .. KV_MAX_KEYS - 1.
+ * @param[in] data - value.
+ * @param[in] len - 1 .. KV_MAX_VALUE_B bytes.
+ * @return    0 on success, -1 on invalid key or length.
+ */
+int kv_put(uint32_t key, const void *data, uint32_t len);
+
+/**
+ * @brief     Get value of the key from the RAM cache.
+ * @param[out] data - buffer for the value.
+ * @param[in] max_len - buffer size, longer values are truncated.
+ * @return    value length, -1 if the key is not set.
+ */
+int kv_get(uint32_t key, void *data, uint32_t max_len);
+
+/**
+ * @brief     Delete the key.
+ * @return    0 on success, -1 on invalid key.
+ */
+int kv_delete(uint32_t key);
+
+/**
+ * @brief     Wait till all changes are written to flash (task context).
+ */
+void kv_sync(void);
+
+/**
+ * @brief     Get number of compactions (sector erases) since the store was created.
+ */
+uint32_t kv_get_erase_count(void);
+
+/**
+ * @brief     Background task writing changes to flash, added to the task table by CONFIG_FLASH_KV.
+ */
+void kv_store_task(void);
+
+#endif /* FLASH_KV_H_ */
@@ -0,0 +1,433 @@
+/*
+ * kernel_config.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ *
+ * All kernel options in one place. Every option can be overridden with -D from the Makefile, and a whole
+ * profile is selected with CONFIG_PROFILE=<name> (passes -DKERNEL_CONFIG_<NAME>):
+ *   - default: all services enabled
+ *   - minimal: scheduler with user tasks only, smallest flash/RAM footprint
+ * Disabled features compile to nothing: their sources are wrapped with #if CONFIG_..., their kernel tasks
+ * are not added to the task table and their hooks in the tick/switch path are removed by the preprocessor.
+ * Run "make size-report" to compare footprint of the profiles.
+ */
+
+#ifndef KERNEL_CONFIG_H_
+#define KERNEL_CONFIG_H_
+
+/* ======================== Profiles ========================================== */
+// Profile only changes defaults, each option can still be overridden with -D
+#if defined(KERNEL_CONFIG_MINIMAL)
+#ifndef CONFIG_SW_TIMERS
+#define CONFIG_SW_TIMERS 0
+#endif
+#ifndef CONFIG_COROUTINES
+#define CONFIG_COROUTINES 0
+#endif
+#ifndef CONFIG_MEM_POOLS
+#define CONFIG_MEM_POOLS 0
+#endif
+#ifndef CONFIG_ACTIVE_OBJECTS
+#define CONFIG_ACTIVE_OBJECTS 0
+#endif
+#ifndef CONFIG_WORK_QUEUE
+#define CONFIG_WORK_QUEUE 0
+#endif
+#ifndef CONFIG_HR_TIMEBASE
+#define CONFIG_HR_TIMEBASE 0
+#endif
+#ifndef CONFIG_DVFS
+#define CONFIG_DVFS 0
+#endif
+#ifndef CONFIG_TASK_BUDGETS
+#define CONFIG_TASK_BUDGETS 0
+#endif
+#ifndef CONFIG_ADMISSION_CONTROL
+#define CONFIG_ADMISSION_CONTROL 0
+#endif
+#ifndef CONFIG_LED_ENGINE
+#define CONFIG_LED_ENGINE 0
+#endif
+#ifndef CONFIG_DMA_COPY
+#define CONFIG_DMA_COPY 0
+#endif
+#ifndef CONFIG_FLASH_KV
+#define CONFIG_FLASH_KV 0
+#endif
+#ifndef CONFIG_UART_DMA
+#define CONFIG_UART_DMA 0
+#endif
+#ifndef CONFIG_STACK_CHECK
+#define CONFIG_STACK_CHECK 0
+#endif
+#ifndef CONFIG_STATS
+#define CONFIG_STATS 0
+#endif
+#ifndef CONFIG_TRACE
+#define CONFIG_TRACE 0
+#endif
+#ifndef CONFIG_HW_COUNTERS
+#define CONFIG_HW_COUNTERS 0
+#endif
+#ifndef CONFIG_BINLOG
+#define CONFIG_BINLOG 0
+#endif
+#ifndef CONFIG_PROFILER
+#define CONFIG_PROFILER 0
+#endif
+#ifndef CONFIG_IDLE_TASK_STACK_SIZE_B
+#define CONFIG_IDLE_TASK_STACK_SIZE_B (128U)
+#endif
+#endif /* KERNEL_CONFIG_MINIMAL */
+
+/* ======================== Clock and tick ==================================== */
+#ifndef CONFIG_CPU_CLOCK_HZ
+#define CONFIG_CPU_CLOCK_HZ (16U * 1000000U)	// 16 MHz, internal processor clock used (HSI)
+#endif
+
+#ifndef CONFIG_TICK_RATE_HZ
+#define CONFIG_TICK_RATE_HZ (1000U)			// Scheduler ticks per second
+#endif
+
+#ifndef CONFIG_HR_TIMEBASE
+#define CONFIG_HR_TIMEBASE 1					// 1 MHz 32-bit TIM2 timebase: kernel_now_us(), delay_us()
+#endif
+
+#ifndef CONFIG_HR_MIN_SLEEP_US
+#define CONFIG_HR_MIN_SLEEP_US (50U)			// Shorter delay_us() calls busy-wait instead of a context switch
+#endif
+
+#ifndef CONFIG_DVFS
+#define CONFIG_DVFS 1							// Load-driven switching between 16, 32 and 64 MHz (port/dvfs.h)
+#endif
+
+#ifndef CONFIG_DVFS_WINDOW_MS
+#define CONFIG_DVFS_WINDOW_MS (100U)			// Load measurement window of the governor
+#endif
+
+#ifndef CONFIG_DVFS_UP_PCT
+#define CONFIG_DVFS_UP_PCT (80U)				// Busier than this: switch to the fastest point
+#endif
+
+#ifndef CONFIG_DVFS_DOWN_PCT
+#define CONFIG_DVFS_DOWN_PCT (50U)				// Switch down to a point where the load stays below this...
+#endif
+
+#ifndef CONFIG_DVFS_DOWN_WINDOWS
+#define CONFIG_DVFS_DOWN_WINDOWS (3U)			// ...for this many windows in a row
+#endif
+
+/* ======================== Scheduling ======================================== */
+#define SCHED_POLICY_ROUND_ROBIN (0)		// All ready tasks in turn, every tick
+#define SCHED_POLICY_PRIORITY (1)			// Highest priority ready task, round-robin among equal priorities,
+											// preemption limited by per-task preemption threshold
+#define SCHED_POLICY_CYCLIC (2)			// Time-partitioned cyclic executive: a schedule table generated from the
+											// task set (make CYCLIC_TASKSET=<file>) gives each minor frame to one task
+
+#ifndef CONFIG_SCHED_POLICY
+#define CONFIG_SCHED_POLICY SCHED_POLICY_ROUND_ROBIN
+#endif
+
+#ifndef CONFIG_KERNEL_TASK_PRIORITY
+#define CONFIG_KERNEL_TASK_PRIORITY (200U)	// Priority of kernel service tasks (timer, coroutine runner)
+#endif
+
+#ifndef CONFIG_TASK_BUDGETS
+#if CONFIG_SCHED_POLICY == SCHED_POLICY_CYCLIC
+#define CONFIG_TASK_BUDGETS 0					// the schedule table already gives every task fixed frames
+#else
+#define CONFIG_TASK_BUDGETS 1					// Per-task CPU time budgets (.budget_us per .budget_period ticks)
+#endif
+#endif
+
+#ifndef CONFIG_ADMISSION_CONTROL
+#define CONFIG_ADMISSION_CONTROL 0				// SCHED_POLICY_PRIORITY: rate-monotonic priorities and response time
+#endif											// test of tasks with .period_us/.wcet_us, see task_admit()
+
+#ifndef CONFIG_RM_TOP_PRIORITY
+#define CONFIG_RM_TOP_PRIORITY (150U)			// Rate-monotonic priority of the shortest period, below kernel tasks
+#endif
+
+#ifndef CONFIG_RTA_SWITCH_OVERHEAD_US
+#define CONFIG_RTA_SWITCH_OVERHEAD_US (10U)		// Context switch cost charged twice per job by the admission test
+#endif
+
+#ifndef CONFIG_KERNEL_TASK_BUDGET_US
+#define CONFIG_KERNEL_TASK_BUDGET_US (500U)		// Admission control: CPU time of a kernel service task at its
+#endif											// priority per budget period, then it runs at priority 0
+
+#ifndef CONFIG_KERNEL_TASK_BUDGET_PERIOD
+#define CONFIG_KERNEL_TASK_BUDGET_PERIOD (10U)	// Budget period of kernel service tasks in ticks
+#endif
+
+/* ======================== Stacks ============================================ */
+#ifndef CONFIG_TASK_STACK_SIZE_B
+#define CONFIG_TASK_STACK_SIZE_B (1024U)		// Default stack of a task
+#endif
+
+#ifndef CONFIG_IDLE_TASK_STACK_SIZE_B
+#define CONFIG_IDLE_TASK_STACK_SIZE_B (256U)
+#endif
+
+#ifndef CONFIG_STACK_AUTOSIZE
+#define CONFIG_STACK_AUTOSIZE 0					// Set by make STACK_AUTOSIZE=1: sizes from the call graph analysis
+#endif
+
+#if CONFIG_STACK_AUTOSIZE
+#include "stack_sizes.h"	// generated by tools/stack_usage: STACK_SIZE_<task entry>, STACK_SIZE_HANDLERS
+// Stack of a task from KERNEL_TASK_LIST, the size given in the list is replaced by the computed one:
+#define TASK_STACK_SIZE(entry, stack_size) STACK_SIZE_##entry
+#ifndef CONFIG_SCHEDULER_STACK_SIZE_B
+#define CONFIG_SCHEDULER_STACK_SIZE_B STACK_SIZE_HANDLERS
+#endif
+#else
+#define TASK_STACK_SIZE(entry, stack_size) (stack_size)
+#endif
+
+#ifndef CONFIG_SCHEDULER_STACK_SIZE_B
+#define CONFIG_SCHEDULER_STACK_SIZE_B (1024U * 2U)	// MSP: exception handlers
+#endif
+
+#ifndef CONFIG_BOOT_STACK_SIZE_B
+#define CONFIG_BOOT_STACK_SIZE_B (1024U)		// MSP used by main() till scheduler starts
+#endif
+
+#ifndef CONFIG_STACK_CHECK
+#define CONFIG_STACK_CHECK 1					// Check stack canary of every task on context switch
+#endif
+
+/* ======================== Diagnostics ======================================= */
+#ifndef CONFIG_STATS
+#define CONFIG_STATS 1							// Count context switches per task
+#endif
+
+#ifndef CONFIG_TRACE
+#define CONFIG_TRACE 0							// Call trace_task_switch() hook on every context switch
+#endif
+
+#ifndef CONFIG_BINLOG
+#define CONFIG_BINLOG 1							// LOG() stores binary records, formatted on host (make log)
+#endif
+
+#ifndef CONFIG_BINLOG_RECORDS
+#define CONFIG_BINLOG_RECORDS (64U)				// Latest messages kept, 32 bytes each, power of 2
+#endif
+
+#ifndef CONFIG_HW_COUNTERS
+#define CONFIG_HW_COUNTERS 0					// Per-task DWT cycle counts
+#endif
+
+#ifndef CONFIG_PROFILER
+#define CONFIG_PROFILER 0						// PC-sampling profiler in SysTick (make profile)
+#endif
+
+#ifndef CONFIG_PROFILER_SLOTS
+#define CONFIG_PROFILER_SLOTS (1024U)			// Distinct (task, PC) pairs, 12 bytes each, power of 2
+#endif
+
+#ifndef CONFIG_PROFILER_AUTOSTART
+#define CONFIG_PROFILER_AUTOSTART 1				// Sample from the first tick, otherwise after profiler_start()
+#endif
+
+/* ======================== Kernel services =================================== */
+#ifndef CONFIG_SW_TIMERS
+#define CONFIG_SW_TIMERS 1
+#endif
+
+#ifndef CONFIG_SW_TIMER_MAX
+#define CONFIG_SW_TIMER_MAX (16U)				// Max number of simultaneously running timers
+#endif
+
+#ifndef CONFIG_COROUTINES
+#define CONFIG_COROUTINES 1
+#endif
+
+#ifndef CONFIG_CO_WHEEL_SIZE
+#define CONFIG_CO_WHEEL_SIZE (64U)				// Coroutine delay wheel slots, power of 2
+#endif
+
+#ifndef CONFIG_MEM_POOLS
+#define CONFIG_MEM_POOLS 1
+#endif
+
+#ifndef CONFIG_ACTIVE_OBJECTS
+#define CONFIG_ACTIVE_OBJECTS 1					// Event-driven active objects, need CONFIG_MEM_POOLS
+#endif
+
+#ifndef CONFIG_AO_MAX_SIGNALS
+#define CONFIG_AO_MAX_SIGNALS (32U)				// Signals which can be published to subscribers
+#endif
+
+#ifndef CONFIG_WORK_QUEUE
+#define CONFIG_WORK_QUEUE 1						// System work queue sys_workq and its worker task
+#endif
+
+#ifndef CONFIG_WORKQ_PRIORITY
+#define CONFIG_WORKQ_PRIORITY CONFIG_KERNEL_TASK_PRIORITY	// Priority of the sys_workq worker
+#endif
+
+#ifndef CONFIG_UART_DMA
+#ifdef OPENOCD_SEMIHOSTING_ENABLED
+#define CONFIG_UART_DMA 0						// stdout goes to semihosting
+#else
+#define CONFIG_UART_DMA 1
+#endif
+#endif
+
+#ifndef CONFIG_UART_TX_BUF_SIZE
+#define CONFIG_UART_TX_BUF_SIZE (1024U)			// power of 2
+#endif
+
+#ifndef CONFIG_DMA_COPY
+#define CONFIG_DMA_COPY 1						// memcpy/memset on DMA2 Stream0, caller sleeps or gets a callback
+#endif
+
+#ifndef CONFIG_DMA_COPY_MIN_BYTES
+#define CONFIG_DMA_COPY_MIN_BYTES (256U)		// Shorter copies are done by CPU, see CONFIG_DMA_COPY_BENCH
+#endif
+
+#ifndef CONFIG_DMA_COPY_BENCH
+#define CONFIG_DMA_COPY_BENCH 0					// Print CPU vs DMA copy cycles at startup to find the crossover
+#endif
+
+#ifndef CONFIG_FLASH_KV
+#define CONFIG_FLASH_KV 1						// Key-value store in flash sectors 10, 11 (see linker script)
+#endif
+
+#ifndef CONFIG_KV_MAX_KEYS
+#define CONFIG_KV_MAX_KEYS (32U)				// Keys are 0 .. CONFIG_KV_MAX_KEYS - 1
+#endif
+
+#ifndef CONFIG_KV_MAX_VALUE_B
+#define CONFIG_KV_MAX_VALUE_B (32U)				// Max value size, all values are cached in RAM
+#endif
+
+#ifndef CONFIG_KV_FLUSH_DELAY_MS
+#define CONFIG_KV_FLUSH_DELAY_MS (100U)			// Writes within this time after the first one go to flash together
+#endif
+
+#ifndef CONFIG_KV_TASK_PRIORITY
+#define CONFIG_KV_TASK_PRIORITY (1U)			// Flash writes run in background
+#endif
+
+#ifndef CONFIG_LED_ENGINE
+#define CONFIG_LED_ENGINE 1						// LEDs blink and dim from TIM3 ISR instead of blinker tasks
+#endif
+
+#ifndef CONFIG_LED_PWM_HZ
+#define CONFIG_LED_PWM_HZ (100U)				// LED PWM frames per second, also pattern time resolution
+#endif
+
+/* ======================== Tasks ============================================= */
+/*
+ * User tasks: X(handler, stack_size_bytes, [TCB attributes]). Task ids are assigned in the order of the list
+ * starting from 1, the first task of the list is started first. Override the whole list with
+ * -DCONFIG_USER_TASKS=... or here. Optional attributes are TCB designated initializers, used by
+ * SCHED_POLICY_PRIORITY:
+ *   .priority = <0..255>             higher value - higher priority, 0 by default
+ *   .preempt_threshold = <0..255>    task is preempted only by tasks with priority above the threshold.
+ *                                    Tasks of one non-preemptive group (priorities <= common threshold) never
+ *                                    preempt each other and keep running till they block. Default: priority.
+ * With CONFIG_TASK_BUDGETS (any policy but SCHED_POLICY_CYCLIC):
+ *   .budget_us = <us>, .budget_period = <ticks>
+ *                                    task may run "budget_us" of CPU time every "budget_period" ticks, then it
+ *                                    is throttled (TASK_THROTTLED) till the next period. No budget by default.
+ *   APERIODIC_SERVER(capacity_us, period_ticks, priority, background_priority)
+ *                                    SCHED_POLICY_PRIORITY: budget and priority of an aperiodic server, which
+ *                                    runs at background_priority instead of being throttled (common.h)
+ * With CONFIG_ADMISSION_CONTROL:
+ *   .period_us = <us>, .wcet_us = <us> [, .deadline_us = <us>]
+ *                                    periodic task: the kernel replaces .priority with a rate-monotonic one and
+ *                                    doesn't start if the response time test finds a deadline miss. Deadline
+ *                                    defaults to the period. Tasks without period interfere with their
+ *                                    budget (.budget_us per .budget_period) and must have one if they can run
+ *                                    at or above the lowest rate-monotonic priority.
+ */
+#ifndef CONFIG_USER_TASKS
+#if CONFIG_LED_ENGINE
+#define CONFIG_USER_TASKS(X)	// LED demo runs on the LED engine (start_led_blinkers()), no tasks needed
+#else
+#define CONFIG_USER_TASKS(X) \
+	X(task_1_handler, CONFIG_TASK_STACK_SIZE_B) \
+	X(task_2_handler, CONFIG_TASK_STACK_SIZE_B) \
+	X(task_3_handler, CONFIG_TASK_STACK_SIZE_B) \
+	X(task_4_handler, CONFIG_TASK_STACK_SIZE_B)
+#endif
+#endif
+
+// Kernel service tasks, present only if the service is enabled. The admission test needs a bound on their load,
+// so with CONFIG_ADMISSION_CONTROL they run as aperiodic servers (common.h):
+#if CONFIG_ADMISSION_CONTROL
+#define KERNEL_TASK_ATTRS(priority_) APERIODIC_SERVER(CONFIG_KERNEL_TASK_BUDGET_US, \
+		CONFIG_KERNEL_TASK_BUDGET_PERIOD, priority_, 0)
+#else
+#define KERNEL_TASK_ATTRS(priority_) .priority = (priority_)
+#endif
+
+#if CONFIG_SW_TIMERS
+#define KERNEL_TIMER_TASK(X) X(sw_timer_service_task, CONFIG_TASK_STACK_SIZE_B, \
+		KERNEL_TASK_ATTRS(CONFIG_KERNEL_TASK_PRIORITY))
+#else
+#define KERNEL_TIMER_TASK(X)
+#endif
+
+#if CONFIG_COROUTINES
+#define KERNEL_COROUTINE_TASK(X) X(coroutine_runner_task, CONFIG_TASK_STACK_SIZE_B, \
+		KERNEL_TASK_ATTRS(CONFIG_KERNEL_TASK_PRIORITY))
+#else
+#define KERNEL_COROUTINE_TASK(X)
+#endif
+
+#if CONFIG_WORK_QUEUE
+#define KERNEL_WORKQ_TASK(X) X(sys_workq_task, CONFIG_TASK_STACK_SIZE_B, KERNEL_TASK_ATTRS(CONFIG_WORKQ_PRIORITY))
+#else
+#define KERNEL_WORKQ_TASK(X)
+#endif
+
+#if CONFIG_FLASH_KV
+#define KERNEL_KV_TASK(X) X(kv_store_task, CONFIG_TASK_STACK_SIZE_B, KERNEL_TASK_ATTRS(CONFIG_KV_TASK_PRIORITY))
+#else
+#define KERNEL_KV_TASK(X)
+#endif
+
+// Full task table. Idle task must be the first one (IDLE_TASK_ID = 0):
+#define KERNEL_TASK_LIST(X) \
+	X(task_idle, CONFIG_IDLE_TASK_STACK_SIZE_B) \
+	CONFIG_USER_TASKS(X) \
+	KERNEL_TIMER_TASK(X) \
+	KERNEL_COROUTINE_TASK(X) \
+	KERNEL_WORKQ_TASK(X) \
+	KERNEL_KV_TASK(X)
+
+/* ======================== Checks ============================================ */
+_Static_assert(CONFIG_SCHED_POLICY == SCHED_POLICY_ROUND_ROBIN || CONFIG_SCHED_POLICY == SCHED_POLICY_PRIORITY ||
+		CONFIG_SCHED_POLICY == SCHED_POLICY_CYCLIC, "Unknown CONFIG_SCHED_POLICY");
+_Static_assert(CONFIG_KERNEL_TASK_PRIORITY <= 255U && CONFIG_WORKQ_PRIORITY <= 255U, "Task priority is 8 bit");
+_Static_assert(CONFIG_CPU_CLOCK_HZ / CONFIG_TICK_RATE_HZ - 1 <= 0x00FFFFFFU, "SysTick reload value exceeds 24 bits");
+_Static_assert(CONFIG_CPU_CLOCK_HZ % CONFIG_TICK_RATE_HZ == 0, "Tick rate must divide CPU clock");
+_Static_assert(!CONFIG_HR_TIMEBASE || CONFIG_CPU_CLOCK_HZ % 1000000U == 0, "Timebase needs CPU clock in whole MHz");
+_Static_assert(CONFIG_TASK_STACK_SIZE_B % 8 == 0 && CONFIG_IDLE_TASK_STACK_SIZE_B % 8 == 0,
+		"Task stacks must be multiple of 8 bytes");
+_Static_assert(CONFIG_IDLE_TASK_STACK_SIZE_B >= 128U, "Idle stack must fit initial context frame");
+_Static_assert((CONFIG_CO_WHEEL_SIZE & (CONFIG_CO_WHEEL_SIZE - 1)) == 0, "CONFIG_CO_WHEEL_SIZE must be power of 2");
+_Static_assert(!CONFIG_ACTIVE_OBJECTS || CONFIG_MEM_POOLS, "Active objects allocate events from memory pools");
+_Static_assert(CONFIG_KV_MAX_VALUE_B <= 255U && CONFIG_KV_MAX_KEYS < 0xFFFFU, "Flash KV record limits");
+_Static_assert(!CONFIG_TASK_BUDGETS || (CONFIG_HR_TIMEBASE && CONFIG_SCHED_POLICY != SCHED_POLICY_CYCLIC),
+		"Task budgets are charged with the timebase, the cyclic table gives fixed frames instead");
+_Static_assert(CONFIG_SCHED_POLICY != SCHED_POLICY_CYCLIC ||
+		!(CONFIG_SW_TIMERS || CONFIG_COROUTINES || CONFIG_WORK_QUEUE || CONFIG_FLASH_KV),
+		"Kernel service tasks have no frames in the cyclic schedule table");
+_Static_assert(!CONFIG_ADMISSION_CONTROL || CONFIG_SCHED_POLICY == SCHED_POLICY_PRIORITY,
+		"Admission control assigns fixed priorities");
+_Static_assert(CONFIG_RM_TOP_PRIORITY <= 255U, "Task priority is 8 bit");
+_Static_assert(!CONFIG_ADMISSION_CONTROL || CONFIG_TASK_BUDGETS,
+		"Admission control bounds the load of tasks without period by their budgets");
+_Static_assert(!CONFIG_DVFS || (CONFIG_WORK_QUEUE && CONFIG_STATS && CONFIG_HR_TIMEBASE),
+		"DVFS governor runs on sys_workq and measures idle time with the timebase");
+_Static_assert(!CONFIG_DVFS || CONFIG_CPU_CLOCK_HZ == 16000000U, "DVFS operating points start from 16 MHz HSI");
+_Static_assert(CONFIG_DVFS_DOWN_PCT < CONFIG_DVFS_UP_PCT && CONFIG_DVFS_UP_PCT < 100U, "DVFS thresholds");
+_Static_assert((CONFIG_UART_TX_BUF_SIZE & (CONFIG_UART_TX_BUF_SIZE - 1)) == 0,
+		"CONFIG_UART_TX_BUF_SIZE must be power of 2");
+
+#endif /* KERNEL_CONFIG_H_ */
@@ -21,8 +21,58 @@ typedef enum led_ {
 	LED_BLUE
 } led_t;
 
+#define LED_MASK(led) (1U << (led))
+#define LED_MASK_ALL (LED_MASK(LED_GREEN) | LED_MASK(LED_ORANGE) | LED_MASK(LED_RED) | LED_MASK(LED_BLUE))
+
+/**
+ * @brief     Turn single LED on or off. Atomic, no critical section is needed.
+ */
 void turn_led(led_t led, led_state_t on_off);
 
+/**
+ * @brief     Turn on and off several LEDs with a single atomic port write.
+ * @param[in] on_mask - LED_MASK() of LEDs to turn on
+ * @param[in] off_mask - LED_MASK() of LEDs to turn off. LEDs present in both masks are turned on.
+ */
+void set_leds(uint32_t on_mask, uint32_t off_mask);
+
 void init_leds(void);
 
+#if CONFIG_LED_ENGINE
+/*
+ * LED engine: TIM3 ISR drives all LEDs, so blinking and dimming need no task and no scheduler activity.
+ * One ISR per PWM frame (CONFIG_LED_PWM_HZ) starts the frame and advances patterns, plus one per distinct
+ * turn-off edge of dimmed LEDs. Every ISR updates all LEDs with one BSRR write. Timer is stopped while all
+ * LEDs are static fully on or off. All calls are fire-and-forget and can be made from tasks or ISRs;
+ * turn_led() and set_leds() also go through the engine and cancel the pattern of the LED.
+ */
+#define LED_BRIGHTNESS_MAX (255U)
+
+/**
+ * @brief     Start TIM3 and its interrupt. Called by init_leds().
+ */
+void led_engine_init(void);
+
+/**
+ * @brief     Keep the LED lit at constant brightness, cancels its pattern.
+ * @param[in] brightness - 0 (off) .. LED_BRIGHTNESS_MAX (fully on), linear PWM duty.
+ */
+void led_set_brightness(led_t led, uint8_t brightness);
+
+/**
+ * @brief     Blink forever: "on_ms" lit at current brightness, "off_ms" dark. Times are rounded to PWM frames,
+ *            and a cycle of unequal times is approximated with 32 steps.
+ */
+void led_blink(led_t led, uint32_t on_ms, uint32_t off_ms);
+
+/**
+ * @brief     Play bit pattern: bit i (LSB first) of "pattern" lights the LED during step i.
+ * @param[in] pattern - step bits.
+ * @param[in] length - number of steps, 1..32.
+ * @param[in] step_ms - duration of one step.
+ * @param[in] repeat - number of times to play the pattern, 0 - forever. The LED turns off after the last one.
+ */
+void led_pattern(led_t led, uint32_t pattern, uint32_t length, uint32_t step_ms, uint32_t repeat);
+#endif /* CONFIG_LED_ENGINE */
+
 #endif /* LED_CONTROLLER_H_ */
@@ -0,0 +1,90 @@
+/*
+ * lf_queue.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ *
+ * Lock-free bounded queues of pointers built on atomic.h, interrupts are never masked:
+ *  - lf_spsc_t: one producer and one consumer (e.g. ISR -> task), wait-free.
+ *  - lf_mpmc_t: any number of producers and consumers (tasks and ISRs), lock-free, one CAS per operation.
+ * Capacity must be a power of 2. Both queues are fully initialized at compile time by their DEFINE macros.
+ */
+
+#ifndef LF_QUEUE_H_
+#define LF_QUEUE_H_
+#include "common.h"
+
+/* ================== Single producer, single consumer ring =================== */
+typedef struct lf_spsc_ {
+	void **				buffer;
+	uint32_t			mask;		// capacity - 1
+	volatile uint32_t	head;		// next slot to write, free running counter, written by producer only
+	volatile uint32_t	tail;		// next slot to read, free running counter, written by consumer only
+} lf_spsc_t;
+
+/**
+ * @brief Define statically allocated SPSC queue "name" of "capacity" (power of 2) pointers.
+ */
+#define LF_SPSC_DEFINE(name, capacity) \
+	void *name##_buffer[(capacity)]; \
+	lf_spsc_t name = { name##_buffer, (capacity) - 1, 0, 0 }
+
+/**
+ * @brief     Put item to the queue. Must be called from the single producer context only.
+ * @return    0 on success, -1 if the queue is full.
+ */
+int lf_spsc_push(lf_spsc_t *q, void *item);
+
+/**
+ * @brief     Take item from the queue. Must be called from the single consumer context only.
+ * @param[out] item - taken item
+ * @return    0 on success, -1 if the queue is empty.
+ */
+int lf_spsc_pop(lf_spsc_t *q, void **item);
+
+/**
+ * @brief     Get number of items in the queue (snapshot).
+ */
+uint32_t lf_spsc_count(lf_spsc_t *q);
+
+/* ================== Multi producer, multi consumer queue ==================== */
+/*
+ * Bounded queue with a sequence number per cell (D. Vyukov). Producers and consumers claim a position with CAS
+ * and the cell sequence tells whether the cell at the position is free or holds published data.
+ * Sequence is stored relative to the cell index, so a zero-initialized queue is valid.
+ * On single core a producer preempted between claiming a cell and publishing it makes consumers of higher
+ * priority see the queue as empty till the producer resumes, no one spins.
+ */
+typedef struct lf_mpmc_cell_ {
+	volatile uint32_t	seq;
+	void *				data;
+} lf_mpmc_cell_t;
+
+typedef struct lf_mpmc_ {
+	lf_mpmc_cell_t *	cells;
+	uint32_t			mask;		// capacity - 1
+	volatile uint32_t	enqueue_pos;
+	volatile uint32_t	dequeue_pos;
+} lf_mpmc_t;
+
+/**
+ * @brief Define statically allocated MPMC queue "name" of "capacity" (power of 2) pointers.
+ */
+#define LF_MPMC_DEFINE(name, capacity) \
+	lf_mpmc_cell_t name##_cells[(capacity)]; \
+	lf_mpmc_t name = { name##_cells, (capacity) - 1, 0, 0 }
+
+/**
+ * @brief     Put item to the queue. Can be called from any task or ISR.
+ * @return    0 on success, -1 if the queue is full.
+ */
+int lf_mpmc_push(lf_mpmc_t *q, void *item);
+
+/**
+ * @brief     Take item from the queue. Can be called from any task or ISR.
+ * @param[out] item - taken item
+ * @return    0 on success, -1 if the queue is empty.
+ */
+int lf_mpmc_pop(lf_mpmc_t *q, void **item);
+
+#endif /* LF_QUEUE_H_ */
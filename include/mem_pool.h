@@ -0,0 +1,75 @@
+/*
+ * mem_pool.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef MEM_POOL_H_
+#define MEM_POOL_H_
+#include "common.h"
+
+#define MEM_POOL_ALIGN (8U)		// Every block is aligned to 8 bytes (enough for uint64_t/double)
+#define MEM_POOL_BLOCK_SIZE(size) ((((size) + MEM_POOL_ALIGN - 1) / MEM_POOL_ALIGN) * MEM_POOL_ALIGN)
+
+/*
+ * Fixed-block pool. Free blocks are linked in a list through their first word, so alloc/free are O(1).
+ * Blocks never handed out yet are taken from the end of the "carved" part of the buffer, which lets the pool
+ * be fully initialized at compile time (no init call required).
+ */
+typedef struct mem_pool_ {
+	uint8_t *	buffer;
+	uint32_t	block_size;		// rounded up to MEM_POOL_ALIGN
+	uint32_t	n_blocks;
+	void *		free_list;		// blocks returned by mem_pool_free()
+	uint32_t	n_carved;		// blocks [0, n_carved) were handed out at least once
+	uint32_t	n_used;
+	uint32_t	max_used;
+	uint32_t	alloc_fails;
+} mem_pool_t;
+
+typedef struct mem_pool_stats_ {
+	uint32_t	block_size;
+	uint32_t	n_blocks;
+	uint32_t	n_used;
+	uint32_t	max_used;		// high watermark
+	uint32_t	alloc_fails;
+} mem_pool_stats_t;
+
+/**
+ * @brief Define statically allocated pool "name" of "n_blocks" blocks with "size" bytes each.
+ *        Use "static MEM_POOL_DEFINE(...)" to make pool local for the file.
+ */
+#define MEM_POOL_DEFINE(name, size, n_blocks_) \
+	uint64_t name##_storage[(MEM_POOL_BLOCK_SIZE(size) * (n_blocks_)) / sizeof(uint64_t)]; \
+	mem_pool_t name = { (uint8_t *)name##_storage, MEM_POOL_BLOCK_SIZE(size), (n_blocks_), 0, 0, 0, 0, 0 }
+
+/* ================== Memory pool user API ==================================== */
+/**
+ * @brief     Initialize pool at run time over user provided buffer (alternative to MEM_POOL_DEFINE).
+ * @param[in] pool - pool descriptor
+ * @param[in] buffer - memory for blocks, aligned to MEM_POOL_ALIGN, n_blocks * MEM_POOL_BLOCK_SIZE(size) bytes
+ * @param[in] size - requested block size in bytes
+ * @param[in] n_blocks - number of blocks
+ */
+void mem_pool_init(mem_pool_t *pool, void *buffer, uint32_t size, uint32_t n_blocks);
+
+/**
+ * @brief     Allocate one block. O(1), can be called from ISR.
+ * @return    pointer to block or NULL if pool is empty.
+ */
+void *mem_pool_alloc(mem_pool_t *pool);
+
+/**
+ * @brief     Return block to the pool. O(1), can be called from ISR.
+ * @return    0 on success, -1 if block doesn't belong to the pool.
+ */
+int mem_pool_free(mem_pool_t *pool, void *block);
+
+/**
+ * @brief     Get usage statistics of the pool.
+ * @param[out] stats - filled with current values
+ */
+void mem_pool_get_stats(mem_pool_t *pool, mem_pool_stats_t *stats);
+
+#endif /* MEM_POOL_H_ */
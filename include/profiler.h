@@ -0,0 +1,67 @@
+/*
+ * profiler.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+#include "common.h"
+
+/*
+ * Statistical PC-sampling profiler. Every SysTick takes the PC stacked by the interrupted code and adds it to a
+ * (task, PC) histogram in profiler_buffer. Samples of interrupted handlers (MSP frame) go to PROFILER_TASK_ISR.
+ * The firmware is never halted: tools/profiler/prof_report.py dumps profiler_buffer over GDB/OpenOCD and
+ * symbolizes it against build/scheduler.elf into per-task hot function reports ("make profile").
+ * Cost is a short hash table probe per tick; samples which don't fit the table are counted as dropped.
+ */
+
+#define PROFILER_MAGIC (0x464F5250U)			// "PROF", checked by the host script
+#define PROFILER_SLOTS CONFIG_PROFILER_SLOTS	// power of 2
+#define PROFILER_TASK_ISR (0xFFU)
+#define PROFILER_TASK_FREE (0U)					// slot.task_plus_1 of an empty slot
+
+typedef struct profiler_slot_ {
+	uint32_t			pc;
+	uint32_t			task_plus_1;	// task id + 1, PROFILER_TASK_FREE for an empty slot
+	uint32_t			count;
+} profiler_slot_t;
+
+// Layout is read by the host script, change both together:
+typedef struct profiler_buffer_ {
+	uint32_t			magic;
+	uint32_t			n_tasks;
+	uint32_t			n_slots;
+	volatile uint32_t	enabled;
+	uint32_t			samples;
+	uint32_t			dropped;			// table full
+	task_handler_t		task_entry[MAX_TASKS];	// handler of every task, gives task names to the host
+	profiler_slot_t		slots[PROFILER_SLOTS];
+} profiler_buffer_t;
+
+extern profiler_buffer_t profiler_buffer;
+
+/**
+ * @brief     Start sampling. Samples collected before are kept.
+ */
+void profiler_start(void);
+
+/**
+ * @brief     Stop sampling.
+ */
+void profiler_stop(void);
+
+/**
+ * @brief     Clear all samples.
+ */
+void profiler_reset(void);
+
+/**
+ * @brief     Add one sample, called from SysTick_Handler.
+ * @param[in] frame - exception stack frame of the interrupted code.
+ * @param[in] exc_return - EXC_RETURN value of the exception: bit 2 set - interrupted code used PSP (a task).
+ */
+void profiler_sample(const uint32_t *frame, uint32_t exc_return);
+
+#endif /* PROFILER_H_ */
@@ -0,0 +1,53 @@
+/*
+ * rta.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef RTA_H_
+#define RTA_H_
+#include <stdint.h>
+
+/*
+ * Schedulability analysis of periodic tasks under fixed priorities, shared by the kernel admission control
+ * (CONFIG_ADMISSION_CONTROL) and the host simulator (tools/sched_sim).
+ */
+
+typedef struct rta_task_ {
+	uint32_t	period_us;
+	uint32_t	wcet_us;
+	uint32_t	deadline_us;
+	uint32_t	jitter_us;		// release jitter: a job can come up to jitter_us after its period starts
+	uint8_t		priority;		// higher value - higher priority
+	uint8_t		threshold;		// preemption threshold, not below priority
+	uint8_t		fixed;			// 1 - bounded load at a fixed priority (budgeted task): only interferes and
+								// blocks, keeps its priority and is not analysed itself
+	uint32_t	response_us;	// result of rta_response_times(): worst-case response, 0 - deadline can be missed
+} rta_task_t;
+
+/**
+ * @brief     Rate-monotonic priorities: the shorter the period, the higher the priority. Tasks with equal periods
+ *            get equal priorities, "top_priority" goes to the shortest period. Thresholds are reset to priorities.
+ *            Fixed entries are skipped.
+ * @return    0 on success, -1 if there are more distinct periods than priorities from "top_priority" down to 0.
+ */
+int32_t rta_assign_rate_monotonic(rta_task_t *set, uint32_t n, uint8_t top_priority);
+
+/**
+ * @brief     Response time analysis: R = B + C + sum over higher (and equal) priority tasks of
+ *            ceil((R + Jj) / Tj) * Cj.
+ *            Equal priorities are counted as interference, which is pessimistic but safe for round-robin ties.
+ *            B is blocking by the longest lower priority job whose preemption threshold is not below the priority.
+ *            Every job is charged two context switches of "overhead_us".
+ *            Fixed entries get no response time and are not counted.
+ * @return    number of tasks which can miss their deadline.
+ */
+uint32_t rta_response_times(rta_task_t *set, uint32_t n, uint32_t overhead_us);
+
+/**
+ * @brief     Total utilization of the task set in 1/1000.
+ */
+uint32_t rta_utilization_permille(const rta_task_t *set, uint32_t n);
+
+#endif /* RTA_H_ */
@@ -14,16 +14,191 @@
  * @brief Main function: initialize:
  *                       - System Fault exception handlers
  *                       - SysTick timer and PendSV (context switch) handlers
- *                       - 4 user tasks and runs them in Thread mode starting from task 1.
+ *                       - all tasks of KERNEL_TASK_LIST and runs them in Thread mode starting from the first user task.
+ * @return -1 if admission control (CONFIG_ADMISSION_CONTROL) rejected the task list, doesn't return otherwise.
  */
-void init_and_run_scheduler(void);
+int32_t init_and_run_scheduler(void);
 
 /**
  * @brief     Sleep for requested scheduler ticks
- * @param[in] tick_count - number of scheduler ticks. Each tick equals to TASK_DURAION time.
+ * @param[in] tick_count - number of scheduler ticks. Each tick equals to 1 / CONFIG_TICK_RATE_HZ seconds.
  */
 void delay_task(uint32_t tick_count);
 
+/**
+ * @brief     Sleep for at least "tick_count" and at most "tick_count + slack" scheduler ticks. Kernel moves the
+ *            wakeup inside the slack to a tick shared with other sleeping tasks.
+ * @param[in] tick_count - minimal number of scheduler ticks to sleep.
+ * @param[in] slack - tolerated extra delay in ticks.
+ */
+void delay_task_slack(uint32_t tick_count, uint32_t slack);
+
+/**
+ * @brief     Block current task till it is notified by task_notify() or timeout expires.
+ *            If notification is already pending, returns immediately.
+ * @param[in] timeout - number of scheduler ticks to wait, WAIT_FOREVER to wait without timeout.
+ * @return    1 if task was notified, 0 on timeout.
+ */
+uint32_t task_wait_notify(uint32_t timeout);
+
+/**
+ * @brief     Notify a task and make it TASK_READY if it waits in task_wait_notify(). A task sleeping in
+ *            delay_task() keeps sleeping, the notification stays pending for its next task_wait_notify().
+ *            Can be called from ISR.
+ * @param[in] task_id - index of the task to notify.
+ */
+void task_notify(uint32_t task_id);
+
+/**
+ * @brief     Suspend current task till task_resume() is called and "wake_flag" is set. Drivers use it to sleep
+ *            on their own events without consuming task notifications.
+ * @param[in] wake_flag - set to non-zero by the waker before it calls task_resume().
+ */
+void task_suspend_until(const volatile uint32_t *wake_flag);
+
+/**
+ * @brief     Make task TASK_READY if it is suspended in task_suspend_until(). Can be called from ISR.
+ * @param[in] task_id - index of the task to resume.
+ */
+void task_resume(uint32_t task_id);
+
+/**
+ * @brief     Change task priority and preemption threshold at run time (SCHED_POLICY_PRIORITY).
+ * @param[in] task_id - index of the task.
+ * @param[in] priority - higher value - higher priority.
+ * @param[in] preempt_threshold - task is preempted only by priorities above it, values below priority mean priority.
+ */
+void task_set_priority(uint32_t task_id, uint8_t priority, uint8_t preempt_threshold);
+
+/**
+ * @brief     Get current scheduler tick.
+ * @return    number of scheduler ticks since scheduler start.
+ */
+uint32_t get_tick_count(void);
+
+/**
+ * @brief     Get index of the running task (X-macro id: <entry>_id).
+ */
+uint32_t get_current_task_id(void);
+
+/**
+ * @brief     Check if scheduler already started running tasks (blocking calls are allowed).
+ * @return    1 if tasks are running, 0 before init_and_run_scheduler() switched to tasks.
+ */
+uint32_t is_scheduler_running(void);
+
+#if CONFIG_STATS
+/**
+ * @brief     Get number of times the task was switched in.
+ */
+uint32_t get_task_switch_count(uint32_t task_id);
+
+/**
+ * @brief     Get total number of context switches (PendSV runs) since scheduler start.
+ */
+uint32_t get_context_switch_count(void);
+
+/**
+ * @brief     Get number of task selections where a higher priority ready task didn't preempt the running one
+ *            because of its preemption threshold.
+ */
+uint32_t get_preemptions_avoided_count(void);
+
+/**
+ * @brief     Get number of wakeups moved within their slack onto a tick where another task wakes up.
+ */
+uint32_t get_merged_wakeup_count(void);
+
+#if CONFIG_HR_TIMEBASE
+/**
+ * @brief     Get total time the task was running in microseconds (measured with kernel_now_us() at every switch).
+ */
+uint32_t get_task_run_time_us(uint32_t task_id);
+#endif /* CONFIG_HR_TIMEBASE */
+#endif /* CONFIG_STATS */
+
+#if CONFIG_TASK_BUDGETS
+/**
+ * @brief     Set CPU budget of the task: "budget_us" of running time every "period_ticks" ticks, starting with a
+ *            full budget now. A task which used up its budget is TASK_THROTTLED till the next period.
+ * @param[in] task_id - index of the task.
+ * @param[in] budget_us - CPU time per period in microseconds, 0 removes the budget.
+ * @param[in] period_ticks - replenishment period in scheduler ticks.
+ */
+void task_set_budget(uint32_t task_id, uint32_t budget_us, uint32_t period_ticks);
+
+/**
+ * @brief     Get CPU time the task used in its current budget period.
+ */
+uint32_t get_task_budget_used_us(uint32_t task_id);
+
+/**
+ * @brief     Get number of times the task used up its budget and was throttled.
+ */
+uint32_t get_task_budget_overruns(uint32_t task_id);
+#endif /* CONFIG_TASK_BUDGETS */
+
+#if CONFIG_ADMISSION_CONTROL
+/**
+ * @brief     Declare the task periodic (or not periodic with period_us = 0) and run the admission test of the
+ *            new task set: rate-monotonic priorities and response time analysis (rta.h). Tasks without period
+ *            interfere with their budgets (aperiodic servers, kernel service tasks), and one without budget at or
+ *            above the lowest periodic priority rejects the set. If it passes, all periodic tasks get their new
+ *            priorities; if not, the failing tasks are logged and nothing changes. Call from one task at a time.
+ * @param[in] task_id - index of the task.
+ * @param[in] period_us - release period in microseconds, 0 removes the task from the analysis.
+ * @param[in] wcet_us - worst-case execution time of one job in microseconds.
+ * @return    0 if admitted, -1 if rejected.
+ */
+int32_t task_admit(uint32_t task_id, uint32_t period_us, uint32_t wcet_us);
+
+/**
+ * @brief     Get worst-case response time of the task found by the admission test, 0 if it is not periodic.
+ */
+uint32_t get_task_response_time_us(uint32_t task_id);
+
+#if CONFIG_STATS && CONFIG_HR_TIMEBASE
+/**
+ * @brief     Print declared utilization (wcet / period) of every periodic task next to the share of CPU time it
+ *            really used since the previous report, marking tasks which ran over their declaration.
+ */
+void task_utilization_report(void);
+#endif
+#endif /* CONFIG_ADMISSION_CONTROL */
+
+#if CONFIG_HW_COUNTERS
+/**
+ * @brief     Copy DWT counts accumulated while the task was running. Cycles of ISRs are charged to the task
+ *            they interrupted.
+ */
+void get_task_hw_counters(uint32_t task_id, task_hw_counters_t *counters);
+
+/**
+ * @brief     Print per task share of all CPU cycles.
+ */
+void task_hw_counters_report(void);
+#endif /* CONFIG_HW_COUNTERS */
+
+#if CONFIG_SCHED_POLICY == SCHED_POLICY_CYCLIC
+/**
+ * @brief     Get index of the current minor frame in the schedule table.
+ */
+uint32_t get_current_frame(void);
+
+/**
+ * @brief     Get number of times the job planned to finish in the frame overran the frame end.
+ */
+uint32_t get_frame_overrun_count(uint32_t frame);
+#endif /* CONFIG_SCHED_POLICY == SCHED_POLICY_CYCLIC */
+
+#if CONFIG_TRACE
+/**
+ * @brief     Trace hook called on every context switch. Weak, override it to record switches.
+ *            With CONFIG_HR_TIMEBASE kernel_now_us() gives the same microsecond timestamps the statistics use.
+ */
+void trace_task_switch(uint32_t from_task, uint32_t to_task);
+#endif /* CONFIG_TRACE */
+
 /* ================== Service API calls used by HAL: ========================== */
 /**
  * @brief     Get PSP stack pointer of currently running task
@@ -44,12 +219,41 @@ void update_to_next_task(void);
 
 /**
  * @brief     Check if any of tasks should be unlocked on current scheduler tick.
+ * @return    number of tasks released on this tick.
  */
-void update_blocked_tasks(void);
+uint32_t update_blocked_tasks(void);
+
+/**
+ * @brief     Check if the running task has to share the CPU with another ready task on this tick (time slicing).
+ */
+uint32_t is_time_slice_due(void);
 
 /**
  * @brief     Increment scheduler tick.
  */
 void update_global_tick_count(void);
 
+#if CONFIG_HW_COUNTERS
+/**
+ * @brief     Add DWT counts since the last harvest to the running task. Called on every tick.
+ */
+void harvest_hw_counters(void);
+#endif
+
+#if CONFIG_TASK_BUDGETS
+/**
+ * @brief     Charge the running task and replenish budgets of tasks whose period starts on this tick.
+ * @return    1 if a throttled task was released or the running task used up its budget.
+ */
+uint32_t update_task_budgets(void);
+#endif
+
+#if CONFIG_SCHED_POLICY == SCHED_POLICY_CYCLIC
+/**
+ * @brief     Called on every scheduler tick instead of update_blocked_tasks(): moves to the next minor frame.
+ * @return    1 if a new frame started and its owner has to be switched in.
+ */
+uint32_t cyclic_advance_frame(void);
+#endif
+
 #endif /* SCHEDULER_H_ */
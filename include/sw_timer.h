@@ -0,0 +1,82 @@
+/*
+ * sw_timer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef SW_TIMER_H_
+#define SW_TIMER_H_
+#include "common.h"
+
+#define SW_TIMER_MAX CONFIG_SW_TIMER_MAX		// Max number of simultaneously running timers
+
+typedef enum {
+	SW_TIMER_ONE_SHOT,
+	SW_TIMER_AUTO_RELOAD
+} sw_timer_mode_t;
+
+struct sw_timer_;
+typedef void (*sw_timer_callback_t)(struct sw_timer_ *timer, void *arg);
+
+/*
+ * Timer descriptor. Allocated by user (usually static), fields are managed by sw_timer_* calls only.
+ * Running timers are kept in a binary min-heap ordered by expiry tick.
+ */
+typedef struct sw_timer_ {
+	uint32_t			expiry;		// tick when callback should run
+	uint32_t			period;		// in scheduler ticks
+	sw_timer_mode_t		mode;
+	sw_timer_callback_t	callback;
+	void *				arg;
+	int32_t				heap_index;	// position in the heap, -1 if timer is not running
+} sw_timer_t;
+
+/* ================== Software timer user API ================================= */
+/**
+ * @brief     Initialize timer descriptor. Timer is not started.
+ * @param[in] timer - timer descriptor
+ * @param[in] mode - SW_TIMER_ONE_SHOT or SW_TIMER_AUTO_RELOAD
+ * @param[in] period - timer period in scheduler ticks (> 0)
+ * @param[in] callback - function called from timer service task on expiry
+ * @param[in] arg - user argument passed to callback
+ */
+void sw_timer_init(sw_timer_t *timer, sw_timer_mode_t mode, uint32_t period,
+		sw_timer_callback_t callback, void *arg);
+
+/**
+ * @brief     Start or restart timer: it expires after "period" ticks from now. Can be called from ISR.
+ * @return    0 on success, -1 if there is no space for one more running timer.
+ */
+int sw_timer_start(sw_timer_t *timer);
+
+/**
+ * @brief     Stop timer. Does nothing if timer is not running. Can be called from ISR.
+ */
+void sw_timer_stop(sw_timer_t *timer);
+
+/**
+ * @brief     Change timer period and restart it with the new period. Can be called from ISR.
+ * @return    0 on success, -1 if period is 0 or timer can't be started.
+ */
+int sw_timer_change_period(sw_timer_t *timer, uint32_t period);
+
+/**
+ * @brief     Check if timer is running.
+ * @return    1 if timer is running, 0 otherwise.
+ */
+uint32_t sw_timer_is_active(const sw_timer_t *timer);
+
+/* ================== Service API calls used by kernel: ======================= */
+/**
+ * @brief     Called on every scheduler tick. Wakes timer service task if the earliest timer expired. O(1).
+ * @param[in] now - current scheduler tick.
+ */
+void sw_timer_check_expired(uint32_t now);
+
+/**
+ * @brief     Timer service task. Runs callbacks of all expired timers on its own stack.
+ */
+void sw_timer_service_task(void);
+
+#endif /* SW_TIMER_H_ */
@@ -15,6 +15,12 @@
  */
 void task_idle(void);
 
+#if CONFIG_LED_ENGINE
+/**
+ * @brief Start blinking of all LEDs on the LED engine.
+ */
+void start_led_blinkers(void);
+#else
 /**
  * @brief User task handler. Can be populated with anything.
  */
@@ -34,5 +40,6 @@ void task_3_handler(void);
  * @brief User task handler. Can be populated with anything.
  */
 void task_4_handler(void);
+#endif /* CONFIG_LED_ENGINE */
 
 #endif /* TASK_H_ */
@@ -0,0 +1,89 @@
+/*
+ * work_queue.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef WORK_QUEUE_H_
+#define WORK_QUEUE_H_
+#include "common.h"
+
+/*
+ * Work queues: ISRs and tasks hand longer processing off to a worker task instead of owning a task per job.
+ * A work item is a statically allocated work_t with a function; submitting it is a lock-free push plus a task
+ * notification, so it can be done from any ISR. The worker takes all submitted items at once and runs them in
+ * submission order (one batch per wakeup), so many deferred jobs share one stack and one context switch.
+ * An item is queued at most once: submitting an item which is still pending does nothing. The pending flag is
+ * cleared before the function runs, so the function may submit its item again.
+ *
+ * The system queue sys_workq runs in the kernel task sys_workq_task at CONFIG_WORKQ_PRIORITY. More queues
+ * with other priorities:
+ *     WORK_QUEUE_DEFINE(io_workq);
+ * and add X(io_workq_task, CONFIG_TASK_STACK_SIZE_B, .priority = 3) to CONFIG_USER_TASKS.
+ *
+ * Aperiodic server: with CONFIG_TASK_BUDGETS and SCHED_POLICY_PRIORITY a queue whose worker is declared with
+ * APERIODIC_SERVER() (common.h) serves bursts of submitted jobs at high priority with low latency, but only for its
+ * capacity per period; the rest of the burst runs at the background priority, so the interference with the
+ * periodic tasks is bounded:
+ *     X(io_workq_task, CONFIG_TASK_STACK_SIZE_B, APERIODIC_SERVER(2000, 10, 250, 1))
+ */
+
+typedef struct work_ work_t;
+typedef void (*work_fn_t)(work_t *work);
+
+struct work_ {
+	work_t *			next;
+	work_fn_t			fn;				// runs in the worker task, may block (delays the rest of the batch)
+	volatile uint32_t	pending;		// submitted and not started yet
+	uint32_t			due_tick;		// delayed work: tick to run at
+};
+
+typedef struct work_queue_ {
+	volatile uint32_t	submitted;		// work_t *: lock-free LIFO of submitted items
+	volatile uint32_t	delayed_in;		// work_t *: lock-free LIFO of delayed items not sorted yet
+	work_t *			delayed;		// worker only: delayed items sorted by due tick
+	uint32_t			task_id;
+	uint32_t			executed;		// items run
+	uint32_t			batches;		// worker wakeups with work
+} work_queue_t;
+
+/**
+ * @brief Initializer of a work item: static work_t rx_work = WORK_INIT(rx_handler);
+ */
+#define WORK_INIT(fn_) { .next = NULL, .fn = (fn_), .pending = 0, .due_tick = 0 }
+
+/**
+ * @brief Define work queue "name" and its worker task handler name##_task, which must be added to
+ *        CONFIG_USER_TASKS.
+ */
+#define WORK_QUEUE_DEFINE(name) \
+	work_queue_t name = { .task_id = name##_task_id }; \
+	void name##_task(void) { work_queue_run(&name); }
+
+extern work_queue_t sys_workq;
+
+/* ================== Work queue user API ===================================== */
+/**
+ * @brief     Queue work item to run in the worker task of the queue. Can be called from ISR.
+ * @return    0 if queued, -1 if the item is already pending.
+ */
+int work_submit(work_queue_t *q, work_t *work);
+
+/**
+ * @brief     Queue work item to run after "delay_ticks" scheduler ticks. Can be called from ISR.
+ * @return    0 if queued, -1 if the item is already pending.
+ */
+int work_submit_delayed(work_queue_t *q, work_t *work, uint32_t delay_ticks);
+
+/**
+ * @brief     Check if work item is queued and not started yet.
+ */
+uint32_t work_is_pending(const work_t *work);
+
+/**
+ * @brief     Body of the worker task: runs submitted and due delayed items, sleeps while there are none.
+ */
+void work_queue_run(work_queue_t *q);
+
+#endif /* WORK_QUEUE_H_ */
@@ -0,0 +1,223 @@
+/*
+ * dma_copy.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+#include "kernel_config.h"
+#if CONFIG_DMA_COPY
+#include <string.h>
+#include "dma_copy.h"
+#include "scheduler.h"
+#include "hal_and_isrs.h"
+#include "stm32f412_periph.h"
+
+#define COPY_DMA_STREAM (0)			// DMA2 Stream0, channel is not used in memory-to-memory mode
+#define COPY_DMA_STREAM_BASE DMA_STREAM_BASE(DMA2_BASE, COPY_DMA_STREAM)
+#define DMA_MAX_ITEMS (0xFFFFU)		// NDTR is 16 bit, longer requests are sent in chunks
+
+/* ======================== GLOBAL STATE ==================================*/
+static dma_req_t *queue_head = NULL;	// request in progress, then waiting ones
+static dma_req_t *queue_tail = NULL;
+static uint32_t chunk_len = 0;			// bytes of the current DMA chunk
+
+/* ========================================================================*/
+
+/**
+ * @brief Start DMA chunk of the first queued request. Must be called with interrupts disabled.
+ */
+static void start_chunk(void)
+{
+	dma_req_t *req = queue_head;
+	if (req == NULL)
+		return;
+	uintptr_t align = (uintptr_t)req->dst | req->len | (req->src ? (uintptr_t)req->src : 0);
+	uint32_t size = (align & 3U) ? DMA_SIZE_BYTE : DMA_SIZE_WORD;
+	uint32_t item_bytes = 1U << size;
+	uint32_t items = req->len / item_bytes;
+	if (items > DMA_MAX_ITEMS)
+		items = DMA_MAX_ITEMS;
+	chunk_len = items * item_bytes;
+
+	// Memory-to-memory: peripheral port reads the source, fill reads the same word again and again
+	REG32(DMA2_BASE + DMA_LIFCR_OFFSET) = DMA_FLAGS_ALL << DMA_FLAGS_POS(COPY_DMA_STREAM);
+	REG32(COPY_DMA_STREAM_BASE + DMA_SxPAR_OFFSET) = req->src ? (uint32_t)req->src : (uint32_t)&req->fill;
+	REG32(COPY_DMA_STREAM_BASE + DMA_SxM0AR_OFFSET) = (uint32_t)req->dst;
+	REG32(COPY_DMA_STREAM_BASE + DMA_SxNDTR_OFFSET) = items;
+	REG32(COPY_DMA_STREAM_BASE + DMA_SxCR_OFFSET) = (DMA_DIR_MEM_TO_MEM << DMA_SxCR_DIR_POS) |
+			((req->src ? 1U : 0U) << DMA_SxCR_PINC_BIT) | (1 << DMA_SxCR_MINC_BIT) |
+			(size << DMA_SxCR_PSIZE_POS) | (size << DMA_SxCR_MSIZE_POS) |
+			(1 << DMA_SxCR_TCIE_BIT) | (1 << DMA_SxCR_TEIE_BIT);
+	REG32(COPY_DMA_STREAM_BASE + DMA_SxCR_OFFSET) |= (1 << DMA_SxCR_EN_BIT);
+}
+
+static void complete(dma_req_t *req, int32_t status)
+{
+	req->status = status;
+	req->done = 1;
+	if (req->callback != NULL)
+		req->callback(req, req->arg);
+	else
+		task_resume(req->waiter);
+}
+
+static int submit(dma_req_t *req, dma_copy_cb_t callback, void *arg)
+{
+	req->callback = callback;
+	req->arg = arg;
+	req->waiter = get_current_task_id();
+	req->status = 0;
+	req->next = NULL;
+	if (req->len < CONFIG_DMA_COPY_MIN_BYTES) {
+		if (req->src != NULL)
+			memcpy(req->dst, req->src, req->len);
+		else
+			memset(req->dst, (uint8_t)req->fill, req->len);
+		req->len = 0;
+		req->done = 1;
+		if (callback != NULL)
+			callback(req, arg);
+		return 1;
+	}
+	req->done = 0;
+
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	if (queue_head == NULL) {
+		queue_head = queue_tail = req;
+		start_chunk();
+	} else {
+		queue_tail->next = req;
+		queue_tail = req;
+	}
+	INTERRUPT_RESTORE(state);
+	return 0;
+}
+
+/**
+ * @brief     Enable DMA2 clock and Stream0 interrupt.
+ */
+void dma_copy_init(void)
+{
+	REG32(RCC_AHB1ENR) |= (1 << RCC_AHB1ENR_DMA2EN_BIT);
+	REG32(COPY_DMA_STREAM_BASE + DMA_SxCR_OFFSET) &= ~(1 << DMA_SxCR_EN_BIT);
+	while (REG32(COPY_DMA_STREAM_BASE + DMA_SxCR_OFFSET) & (1 << DMA_SxCR_EN_BIT));
+	// Direct mode is not allowed for memory-to-memory, use the FIFO:
+	REG32(COPY_DMA_STREAM_BASE + DMA_SxFCR_OFFSET) = (1 << DMA_SxFCR_DMDIS_BIT) | DMA_SxFCR_FTH_FULL;
+	nvic_enable_irq(IRQ_NUM_DMA2_STREAM0);
+}
+
+int dma_memcpy_async(dma_req_t *req, void *dst, const void *src, uint32_t len, dma_copy_cb_t callback, void *arg)
+{
+	req->dst = dst;
+	req->src = src;
+	req->len = len;
+	return submit(req, callback, arg);
+}
+
+int dma_memset_async(dma_req_t *req, void *dst, uint8_t value, uint32_t len, dma_copy_cb_t callback, void *arg)
+{
+	req->dst = dst;
+	req->src = NULL;
+	req->len = len;
+	req->fill = value * 0x01010101U;
+	return submit(req, callback, arg);
+}
+
+/**
+ * @brief     Wait till the request is done.
+ */
+int32_t dma_copy_wait(dma_req_t *req)
+{
+	if (is_scheduler_running() && !is_in_handler_mode() && get_current_task_id() != IDLE_TASK_ID)
+		task_suspend_until(&req->done);
+	while (!req->done);
+	return req->status;
+}
+
+void *dma_memcpy(void *dst, const void *src, uint32_t len)
+{
+	dma_req_t req;
+	if (dma_memcpy_async(&req, dst, src, len, NULL, NULL) == 0)
+		dma_copy_wait(&req);
+	return dst;
+}
+
+void *dma_memset(void *dst, uint8_t value, uint32_t len)
+{
+	dma_req_t req;
+	if (dma_memset_async(&req, dst, value, len, NULL, NULL) == 0)
+		dma_copy_wait(&req);
+	return dst;
+}
+
+#if CONFIG_DMA_COPY_BENCH
+#define BENCH_MAX_BYTES (8192U)
+
+static uint32_t bench_buf_a[BENCH_MAX_BYTES / 4];
+static uint32_t bench_buf_b[BENCH_MAX_BYTES / 4];
+
+/**
+ * @brief     Measure CPU and DMA copy time for sizes 16 B .. 8 KB and print the crossover.
+ */
+void dma_copy_benchmark(void)
+{
+	uint32_t crossover = 0;
+	dma_req_t req;
+	dwt_cycle_counter_enable();
+	printf("DMA copy benchmark, cycles:\n%8s %8s %8s\n", "bytes", "cpu", "dma");
+	for (uint32_t len = 16; len <= BENCH_MAX_BYTES; len *= 2) {
+		uint32_t start = dwt_get_cycles();
+		memcpy(bench_buf_b, bench_buf_a, len);
+		uint32_t cpu = dwt_get_cycles() - start;
+
+		// Queue directly, bypassing the CPU fallback of submit():
+		start = dwt_get_cycles();
+		req = (dma_req_t){ .dst = (uint8_t *)bench_buf_b, .src = (uint8_t *)bench_buf_a, .len = len,
+				.waiter = IDLE_TASK_ID };
+		uint32_t state;
+		INTERRUPT_SAVE_AND_DISABLE(state);
+		queue_head = queue_tail = &req;
+		start_chunk();
+		INTERRUPT_RESTORE(state);
+		while (!req.done);
+		uint32_t dma = dwt_get_cycles() - start;
+
+		printf("%8lu %8lu %8lu\n", (unsigned long)len, (unsigned long)cpu, (unsigned long)dma);
+		if (crossover == 0 && dma < cpu)
+			crossover = len;
+	}
+	printf("DMA is faster from %lu bytes (CONFIG_DMA_COPY_MIN_BYTES = %u)\n",
+			(unsigned long)crossover, CONFIG_DMA_COPY_MIN_BYTES);
+}
+#endif /* CONFIG_DMA_COPY_BENCH */
+
+/* ================================== ISRS =========================== */
+/**
+ * @brief DMA chunk is finished: continue the request, or complete it and start the next one.
+ */
+void DMA2_Stream0_IRQHandler(void)
+{
+	uint32_t flags = (REG32(DMA2_BASE + DMA_LISR_OFFSET) >> DMA_FLAGS_POS(COPY_DMA_STREAM)) & DMA_FLAGS_ALL;
+	REG32(DMA2_BASE + DMA_LIFCR_OFFSET) = flags << DMA_FLAGS_POS(COPY_DMA_STREAM);
+	dma_req_t *req = queue_head;
+	if (req == NULL || !(flags & (DMA_FLAG_TCIF | DMA_FLAG_TEIF)))
+		return;
+
+	if (!(flags & DMA_FLAG_TEIF)) {
+		req->dst += chunk_len;
+		if (req->src != NULL)
+			req->src += chunk_len;
+		req->len -= chunk_len;
+		if (req->len != 0) {
+			start_chunk();
+			return;
+		}
+	}
+	// Next request starts before the callback, which may queue a new one:
+	queue_head = req->next;
+	start_chunk();
+	complete(req, (flags & DMA_FLAG_TEIF) ? -1 : 0);
+}
+
+#endif /* CONFIG_DMA_COPY */
@@ -0,0 +1,80 @@
+/*
+ * dma_copy.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef DMA_COPY_H_
+#define DMA_COPY_H_
+#include "common.h"
+
+/*
+ * Memory-to-memory copy and fill on DMA2 Stream0 (only DMA2 can do memory-to-memory transfers).
+ * Requests are queued and served one after another by the DMA interrupt. The caller either sleeps in
+ * dma_copy_wait() while other tasks use the CPU, or gets a callback from the DMA ISR. Transfers shorter than
+ * CONFIG_DMA_COPY_MIN_BYTES are done by the CPU at once, because DMA setup and the completion interrupt cost
+ * more than the copy itself (CONFIG_DMA_COPY_BENCH measures the crossover). Word transfers are used when
+ * addresses and length are 4-byte aligned, byte transfers otherwise.
+ */
+
+typedef struct dma_req_ dma_req_t;
+typedef void (*dma_copy_cb_t)(dma_req_t *req, void *arg);
+
+// Request is owned by the caller and must not be reused or go out of scope before it is done:
+struct dma_req_ {
+	uint8_t *			dst;
+	const uint8_t *		src;		// NULL for fill
+	uint32_t			len;		// bytes left
+	uint32_t			fill;		// fill byte replicated to a word, DMA reads it as the fixed source
+	dma_copy_cb_t		callback;	// called from DMA ISR (or from the caller for CPU copies), may be NULL
+	void *				arg;
+	uint32_t			waiter;		// task which submitted the request
+	volatile uint32_t	done;
+	int32_t				status;		// 0 - ok, -1 - DMA transfer error
+	dma_req_t *			next;
+};
+
+/**
+ * @brief     Enable DMA2 clock and Stream0 interrupt.
+ */
+void dma_copy_init(void);
+
+/**
+ * @brief     Queue copy of "len" bytes. Doesn't wait, can be called from ISR (also from a completion callback).
+ * @param[in] req - request storage, owned by the caller till it is done.
+ * @param[in] callback - called on completion, NULL if the caller uses dma_copy_wait().
+ * @return    0 if queued to DMA, 1 if it was short and is already done by the CPU (callback already called).
+ */
+int dma_memcpy_async(dma_req_t *req, void *dst, const void *src, uint32_t len, dma_copy_cb_t callback, void *arg);
+
+/**
+ * @brief     Queue fill of "len" bytes with "value". Same rules as dma_memcpy_async().
+ */
+int dma_memset_async(dma_req_t *req, void *dst, uint8_t value, uint32_t len, dma_copy_cb_t callback, void *arg);
+
+/**
+ * @brief     Wait till the request is done. Task sleeps, before scheduler start or in ISR it busy-waits.
+ * @return    0 on success, -1 on DMA transfer error.
+ */
+int32_t dma_copy_wait(dma_req_t *req);
+
+/**
+ * @brief     Blocking memcpy: CPU for short copies, DMA with the calling task asleep for long ones.
+ */
+void *dma_memcpy(void *dst, const void *src, uint32_t len);
+
+/**
+ * @brief     Blocking memset: CPU for short fills, DMA with the calling task asleep for long ones.
+ */
+void *dma_memset(void *dst, uint8_t value, uint32_t len);
+
+#if CONFIG_DMA_COPY_BENCH
+/**
+ * @brief     Measure CPU and DMA copy time (DWT cycles) for sizes 16 B .. 8 KB, print them and the smallest size
+ *            where DMA is faster. DMA time includes setup and the completion interrupt. Run before scheduler.
+ */
+void dma_copy_benchmark(void);
+#endif /* CONFIG_DMA_COPY_BENCH */
+
+#endif /* DMA_COPY_H_ */
@@ -0,0 +1,193 @@
+/*
+ * dvfs.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+#include "kernel_config.h"
+#if CONFIG_DVFS
+#include "dvfs.h"
+#include "scheduler.h"
+#include "work_queue.h"
+#include "timebase.h"
+#include "hal_and_isrs.h"
+#include "stm32f412_periph.h"
+
+// PLL from HSI: 16 MHz / M 8 = 2 MHz, x N 128 = VCO 256 MHz, / P 4 = 64 MHz (Q 8 and R 2 keep their outputs
+// in range, they are not used)
+#define PLL_CONFIG ((8U << RCC_PLLCFGR_PLLM_POS) | (128U << RCC_PLLCFGR_PLLN_POS) | \
+		(1U << RCC_PLLCFGR_PLLP_POS) | (8U << RCC_PLLCFGR_PLLQ_POS) | (2U << RCC_PLLCFGR_PLLR_POS))
+
+#define CFGR(sw, hpre, ppre1) (((sw) << RCC_CFGR_SW_POS) | ((hpre) << RCC_CFGR_HPRE_POS) | \
+		((ppre1) << RCC_CFGR_PPRE1_POS))
+
+#define WINDOW_TICKS ((CONFIG_DVFS_WINDOW_MS * CONFIG_TICK_RATE_HZ) / 1000U)
+#define NOT_PINNED (0xFFU)
+
+typedef struct {
+	uint32_t	hz;
+	uint32_t	cfgr;		// SW, HPRE and PPRE1 fields of RCC_CFGR
+	uint32_t	latency;	// flash wait states
+} dvfs_point_t;
+
+// Slowest first. APB1 = 8 MHz, APB1 timers = 16 MHz at every point:
+static const dvfs_point_t points[] = {
+	{ 16000000U, CFGR(RCC_CFGR_SW_HSI, RCC_CFGR_HPRE_DIV1, RCC_CFGR_PPRE1_DIV2), 0 },
+	{ 32000000U, CFGR(RCC_CFGR_SW_PLL, RCC_CFGR_HPRE_DIV2, RCC_CFGR_PPRE1_DIV4), 1 },
+	{ 64000000U, CFGR(RCC_CFGR_SW_PLL, RCC_CFGR_HPRE_DIV1, RCC_CFGR_PPRE1_DIV8), 1 },
+};
+#define N_POINTS (sizeof(points) / sizeof(points[0]))
+
+_Static_assert(WINDOW_TICKS > 0, "CONFIG_DVFS_WINDOW_MS shorter than a tick");
+
+/* ======================== GLOBAL STATE ==================================*/
+static volatile uint32_t current = 0;				// index into points[]
+static volatile uint32_t pinned = NOT_PINNED;
+static uint32_t load_pct = 0;
+static uint32_t slow_windows = 0;					// consecutive windows a slower point would do
+static uint32_t window_start_us;
+static uint32_t window_start_idle_us;
+
+static void governor(work_t *work);
+static void apply_pin(work_t *work);
+static work_t governor_work = WORK_INIT(governor);
+static work_t pin_work = WORK_INIT(apply_pin);
+
+/* ========================================================================*/
+
+static void set_flash_latency(uint32_t latency)
+{
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	uint32_t acr = REG32(FLASH_IF_BASE + FLASH_ACR_OFFSET) & ~FLASH_ACR_LATENCY_MASK;
+	REG32(FLASH_IF_BASE + FLASH_ACR_OFFSET) = acr | latency;
+	while ((REG32(FLASH_IF_BASE + FLASH_ACR_OFFSET) & FLASH_ACR_LATENCY_MASK) != latency);	// takes effect
+	INTERRUPT_RESTORE(state);
+}
+
+/**
+ * @brief     Switch to operating point "to". Only called from sys_workq_task (or before the scheduler starts),
+ *            so switches don't overlap.
+ */
+static void switch_point(uint32_t to)
+{
+	const dvfs_point_t *from_p = &points[current];
+	const dvfs_point_t *to_p = &points[to];
+	if (to == current)
+		return;
+
+	uint32_t to_pll = ((to_p->cfgr >> RCC_CFGR_SW_POS) & 0x3U) == RCC_CFGR_SW_PLL;
+	if (to_pll) {
+		REG32(RCC_CR) |= (1U << RCC_CR_PLLON_BIT);
+		while (!(REG32(RCC_CR) & (1U << RCC_CR_PLLRDY_BIT)));
+	}
+	if (to_p->latency > from_p->latency)
+		set_flash_latency(to_p->latency);	// more wait states before the clock goes up
+
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	uint32_t counts_left = REG32(SYSTICK_CVR);
+	REG32(RCC_CFGR) = (REG32(RCC_CFGR) & ~RCC_CFGR_CLOCK_MASK) | to_p->cfgr;
+	while (((REG32(RCC_CFGR) >> RCC_CFGR_SWS_POS) & 0x3U) != ((to_p->cfgr >> RCC_CFGR_SW_POS) & 0x3U));
+	systick_change_clock(counts_left, from_p->hz, to_p->hz);
+	current = to;
+	INTERRUPT_RESTORE(state);
+
+	if (to_p->latency < from_p->latency)
+		set_flash_latency(to_p->latency);	// fewer wait states after the clock went down
+	if (!to_pll)
+		REG32(RCC_CR) &= ~(1U << RCC_CR_PLLON_BIT);
+}
+
+/* Busy percentage of the window since the last call */
+static uint32_t measure_load(void)
+{
+	uint32_t now = kernel_now_us();
+	uint32_t idle = get_task_run_time_us(IDLE_TASK_ID);
+	uint32_t elapsed = now - window_start_us;
+	uint32_t idle_in_window = idle - window_start_idle_us;
+	window_start_us = now;
+	window_start_idle_us = idle;
+	if (elapsed == 0 || idle_in_window >= elapsed)
+		return 0;
+	return 100U - (uint32_t)(((uint64_t)idle_in_window * 100U) / elapsed);
+}
+
+/* Slowest point at which "load" (measured at the current point) stays below CONFIG_DVFS_DOWN_PCT */
+static uint32_t slowest_fitting_point(uint32_t load)
+{
+	for (uint32_t i = 0; i < current; i++) {
+		if ((uint64_t)load * points[current].hz < (uint64_t)CONFIG_DVFS_DOWN_PCT * points[i].hz)
+			return i;
+	}
+	return current;
+}
+
+static void governor(work_t *work)
+{
+	load_pct = measure_load();
+	if (pinned == NOT_PINNED) {
+		uint32_t slower = slowest_fitting_point(load_pct);
+		if (load_pct > CONFIG_DVFS_UP_PCT) {
+			slow_windows = 0;
+			switch_point(N_POINTS - 1);
+		} else if (slower < current) {
+			if (++slow_windows >= CONFIG_DVFS_DOWN_WINDOWS) {
+				slow_windows = 0;
+				switch_point(slower);
+			}
+		} else {
+			slow_windows = 0;
+		}
+	}
+	work_submit_delayed(&sys_workq, work, WINDOW_TICKS);
+}
+
+static void apply_pin(work_t *work)
+{
+	uint32_t to = pinned;
+	if (to != NOT_PINNED)
+		switch_point(to);
+	slow_windows = 0;
+}
+
+void dvfs_init(void)
+{
+	REG32(RCC_CR) &= ~(1U << RCC_CR_PLLON_BIT);
+	while (REG32(RCC_CR) & (1U << RCC_CR_PLLRDY_BIT));
+	REG32(RCC_PLLCFGR) = PLL_CONFIG;	// PLL source HSI (PLLSRC = 0)
+	// Reset clock is the slowest point, only APB1 gets its prescaler:
+	REG32(RCC_CFGR) = (REG32(RCC_CFGR) & ~RCC_CFGR_CLOCK_MASK) | points[0].cfgr;
+	current = 0;
+	// Runs in sys_workq_task after the scheduler starts (pre-start submit doesn't reschedule):
+	work_submit_delayed(&sys_workq, &governor_work, WINDOW_TICKS);
+}
+
+uint32_t dvfs_get_hz(void)
+{
+	return points[current].hz;
+}
+
+int dvfs_pin(uint32_t hz)
+{
+	for (uint32_t i = 0; i < N_POINTS; i++) {
+		if (points[i].hz == hz) {
+			pinned = i;
+			work_submit(&sys_workq, &pin_work);
+			return 0;
+		}
+	}
+	return -1;
+}
+
+void dvfs_unpin(void)
+{
+	pinned = NOT_PINNED;
+}
+
+uint32_t dvfs_get_load_pct(void)
+{
+	return load_pct;
+}
+
+#endif /* CONFIG_DVFS */
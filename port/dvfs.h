@@ -0,0 +1,56 @@
+/*
+ * dvfs.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef DVFS_H_
+#define DVFS_H_
+#include "common.h"
+
+/*
+ * Load-driven clock scaling. Every CONFIG_DVFS_WINDOW_MS a work item on sys_workq measures the busy fraction of
+ * the CPU (1 - idle task run time / window) and picks an operating point:
+ *   - busy above CONFIG_DVFS_UP_PCT: the fastest point at once, so a burst gets full headroom in one window;
+ *   - for CONFIG_DVFS_DOWN_WINDOWS windows in a row busy enough to fit a slower point below
+ *     CONFIG_DVFS_DOWN_PCT: the slowest such point. The gap between the thresholds is the hysteresis.
+ *
+ * Operating points: 16 MHz HSI (PLL off), 32 and 64 MHz from the PLL. The APB1 prescaler follows the AHB
+ * clock, so TIM2 (timebase), TIM3 (LED engine) and USART2 see the same clock at every point and are never
+ * reprogrammed. SysTick is rescaled in the switch (systick_change_clock()), the tick in progress keeps its
+ * remaining time, so tick counts, delays and timeouts are not affected by a switch.
+ * Run time statistics are in microseconds of the timebase, DWT cycle counts are CPU cycles of the point
+ * the CPU was running at.
+ */
+
+/**
+ * @brief     Configure clock tree for the slowest point (16 MHz HSI) and start the governor. Call first in main(),
+ *            before peripherals which use APB1 clocks are initialized.
+ */
+void dvfs_init(void);
+
+/**
+ * @brief     Get current CPU clock. Can be called from ISR.
+ * @return    CPU clock in Hz.
+ */
+uint32_t dvfs_get_hz(void);
+
+/**
+ * @brief     Run at a fixed frequency, until dvfs_unpin(). The switch is done in sys_workq_task.
+ * @param[in] hz - one of the operating points: 16000000, 32000000 or 64000000.
+ * @return    0 on success, -1 if "hz" is not an operating point.
+ */
+int dvfs_pin(uint32_t hz);
+
+/**
+ * @brief     Return frequency selection to the governor.
+ */
+void dvfs_unpin(void);
+
+/**
+ * @brief     Get busy percentage of the last governor window.
+ */
+uint32_t dvfs_get_load_pct(void);
+
+#endif /* DVFS_H_ */
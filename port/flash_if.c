@@ -0,0 +1,124 @@
+/*
+ * flash_if.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+#include "kernel_config.h"
+#if CONFIG_FLASH_KV
+#include "flash_if.h"
+#include "scheduler.h"
+#include "hal_and_isrs.h"
+#include "stm32f412_periph.h"
+
+/* ======================== GLOBAL STATE ==================================*/
+static volatile uint32_t erase_done = 1;
+static volatile int32_t erase_status = 0;
+static uint32_t erase_waiter = 0;
+
+/* ========================================================================*/
+
+static void flash_unlock(void)
+{
+	if (REG32(FLASH_IF_BASE + FLASH_CR_OFFSET) & (1U << FLASH_CR_LOCK_BIT)) {
+		REG32(FLASH_IF_BASE + FLASH_KEYR_OFFSET) = FLASH_KEY1;
+		REG32(FLASH_IF_BASE + FLASH_KEYR_OFFSET) = FLASH_KEY2;
+	}
+}
+
+static void flash_lock(void)
+{
+	REG32(FLASH_IF_BASE + FLASH_CR_OFFSET) = (1U << FLASH_CR_LOCK_BIT);
+}
+
+static inline uint32_t flash_busy(void)
+{
+	return REG32(FLASH_IF_BASE + FLASH_SR_OFFSET) & (1U << FLASH_SR_BSY_BIT);
+}
+
+/* Clear EOP and error flags, return -1 if there were errors */
+static int32_t flash_clear_status(void)
+{
+	uint32_t sr = REG32(FLASH_IF_BASE + FLASH_SR_OFFSET);
+	REG32(FLASH_IF_BASE + FLASH_SR_OFFSET) = sr & ((1U << FLASH_SR_EOP_BIT) | FLASH_SR_ERRORS);
+	return (sr & FLASH_SR_ERRORS) ? -1 : 0;
+}
+
+/* Flash content changed under the ART data cache, drop cached lines */
+static void flash_reset_data_cache(void)
+{
+	REG32(FLASH_IF_BASE + FLASH_ACR_OFFSET) &= ~(1U << FLASH_ACR_DCEN_BIT);
+	REG32(FLASH_IF_BASE + FLASH_ACR_OFFSET) |= (1U << FLASH_ACR_DCRST_BIT);
+	REG32(FLASH_IF_BASE + FLASH_ACR_OFFSET) &= ~(1U << FLASH_ACR_DCRST_BIT);
+	REG32(FLASH_IF_BASE + FLASH_ACR_OFFSET) |= (1U << FLASH_ACR_DCEN_BIT);
+}
+
+/**
+ * @brief     Enable FLASH interrupt and move the vector table to SRAM.
+ */
+void flash_if_init(void)
+{
+	relocate_vector_table_to_sram();
+	nvic_enable_irq(IRQ_NUM_FLASH);
+}
+
+/**
+ * @brief     Erase one sector, calling task sleeps till the erase is done.
+ */
+int flash_if_erase_sector(uint32_t sector)
+{
+	uint32_t may_sleep = is_scheduler_running() && !is_in_handler_mode() &&
+			get_current_task_id() != IDLE_TASK_ID;
+	while (flash_busy());
+	flash_unlock();
+	flash_clear_status();
+	erase_waiter = get_current_task_id();
+	erase_done = 0;
+	REG32(FLASH_IF_BASE + FLASH_CR_OFFSET) = (FLASH_PSIZE_WORD << FLASH_CR_PSIZE_POS) | (1U << FLASH_CR_SER_BIT) |
+			(sector << FLASH_CR_SNB_POS) | (may_sleep ? ((1U << FLASH_CR_EOPIE_BIT) | (1U << FLASH_CR_ERRIE_BIT)) : 0);
+	REG32(FLASH_IF_BASE + FLASH_CR_OFFSET) |= (1U << FLASH_CR_STRT_BIT);
+	if (may_sleep) {
+		task_suspend_until(&erase_done);
+	} else {
+		while (flash_busy());
+		erase_status = flash_clear_status();
+	}
+	flash_lock();
+	flash_reset_data_cache();
+	return erase_status;
+}
+
+/**
+ * @brief     Program words to erased flash.
+ */
+int flash_if_program(uint32_t addr, const uint32_t *words, uint32_t n_words)
+{
+	int32_t status = 0;
+	while (flash_busy());
+	flash_unlock();
+	flash_clear_status();
+	REG32(FLASH_IF_BASE + FLASH_CR_OFFSET) = (FLASH_PSIZE_WORD << FLASH_CR_PSIZE_POS) | (1U << FLASH_CR_PG_BIT);
+	for (uint32_t i = 0; i < n_words && status == 0; i++) {
+		REG32(addr + 4 * i) = words[i];
+		while (flash_busy());
+		status = flash_clear_status();
+	}
+	flash_lock();
+	flash_reset_data_cache();
+	return status;
+}
+
+/* ================================== ISRS =========================== */
+/**
+ * @brief Sector erase finished: wake the erasing task.
+ */
+void FLASH_IRQHandler(void)
+{
+	REG32(FLASH_IF_BASE + FLASH_CR_OFFSET) &= ~((1U << FLASH_CR_EOPIE_BIT) | (1U << FLASH_CR_ERRIE_BIT) |
+			(1U << FLASH_CR_SER_BIT));
+	erase_status = flash_clear_status();
+	erase_done = 1;
+	task_resume(erase_waiter);
+}
+
+#endif /* CONFIG_FLASH_KV */
@@ -0,0 +1,44 @@
+/*
+ * flash_if.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef FLASH_IF_H_
+#define FLASH_IF_H_
+#include "common.h"
+
+/*
+ * Flash program/erase driver. Erase or program stalls every read from flash (single bank), so the driver runs
+ * from SRAM (flash_if.o is placed into SRAM by the linker script) and the vector table is moved to SRAM.
+ * The erasing task sleeps till the FLASH end-of-operation interrupt, other tasks keep running as long as their
+ * code is in SRAM too (see RAMFUNC). One user at a time: the driver doesn't queue operations.
+ */
+
+// Sectors 5..11 of STM32F412 are 128 KB each:
+#define FLASH_SECTOR_128K_SIZE (128U * 1024U)
+#define FLASH_SECTOR_ADDR(n) (0x08020000U + ((n) - 5U) * FLASH_SECTOR_128K_SIZE)
+
+/**
+ * @brief     Enable FLASH interrupt and move the vector table to SRAM.
+ */
+void flash_if_init(void);
+
+/**
+ * @brief     Erase one sector. Calling task sleeps till the erase is done, before scheduler start it busy-waits.
+ * @param[in] sector - sector number.
+ * @return    0 on success, -1 on error.
+ */
+int flash_if_erase_sector(uint32_t sector);
+
+/**
+ * @brief     Program words to erased flash. Each word stalls flash reads for ~16 us, no sleeping.
+ * @param[in] addr - destination, word aligned.
+ * @param[in] words - data.
+ * @param[in] n_words - number of words.
+ * @return    0 on success, -1 on error.
+ */
+int flash_if_program(uint32_t addr, const uint32_t *words, uint32_t n_words);
+
+#endif /* FLASH_IF_H_ */
@@ -0,0 +1,23 @@
+/*
+ * gpio.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+#include "gpio.h"
+
+/**
+ * @brief     Enable port clock and configure pin as output. Not atomic: call before pins are used concurrently.
+ */
+void gpio_init_output(const gpio_pin_t *pin, gpio_output_type_t type)
+{
+	REG32(RCC_AHB1ENR) |= (1 << pin->port);
+
+	REG32(pin->port_base + GPIO_MODER_OFFSET) &= ~(0x3U << (pin->num * 2));
+	REG32(pin->port_base + GPIO_MODER_OFFSET) |= (GPIO_MODE_OUTPUT << (pin->num * 2));
+
+	if (type == GPIO_OPEN_DRAIN)
+		REG32(pin->port_base + GPIO_OTYPER_OFFSET) |= pin->mask;
+	else
+		REG32(pin->port_base + GPIO_OTYPER_OFFSET) &= ~pin->mask;
+}
@@ -0,0 +1,78 @@
+/*
+ * gpio.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef GPIO_H_
+#define GPIO_H_
+#include "common.h"
+#include "stm32f412_periph.h"
+
+/*
+ * Output updates go through BSRR register: one bus write sets and resets any set of pins of the port,
+ * there is no read-modify-write of ODR, so tasks and ISRs updating different pins never lose updates
+ * and need no critical section.
+ */
+
+// Pin descriptor, declare it const so it is resolved at compile time and lives in flash:
+typedef struct gpio_pin_ {
+	uint32_t	port_base;
+	uint16_t	mask;		// 1 << pin number
+	uint8_t		port;		// GPIO_PORT_A ... GPIO_PORT_H
+	uint8_t		num;		// pin number 0 .. 15
+} gpio_pin_t;
+
+#define GPIO_PIN(port_, num_) { GPIO_PORT_BASE(port_), (1U << (num_)), (port_), (num_) }
+
+typedef enum {
+	GPIO_PUSH_PULL,
+	GPIO_OPEN_DRAIN
+} gpio_output_type_t;
+
+/**
+ * @brief     Enable port clock and configure pin as output. Not atomic: call before pins are used concurrently.
+ * @param[in] pin - pin descriptor
+ * @param[in] type - output type
+ */
+void gpio_init_output(const gpio_pin_t *pin, gpio_output_type_t type);
+
+/**
+ * @brief     Set and reset several pins of one port in a single atomic write. If a pin is in both masks, set wins.
+ * @param[in] port_base - GPIO_PORT_BASE(port)
+ * @param[in] set - mask of pins to drive high
+ * @param[in] clear - mask of pins to drive low
+ */
+static inline void gpio_write_mask(uint32_t port_base, uint16_t set, uint16_t clear)
+{
+	REG32(port_base + GPIO_BSRR_OFFSET) = (uint32_t)set | ((uint32_t)clear << 16);
+}
+
+/**
+ * @brief     Drive pin high or low with single atomic write.
+ */
+static inline void gpio_write(const gpio_pin_t *pin, uint32_t value)
+{
+	REG32(pin->port_base + GPIO_BSRR_OFFSET) = value ? pin->mask : ((uint32_t)pin->mask << 16);
+}
+
+/**
+ * @brief     Toggle pins of one port. Pins which are not in the mask are not touched.
+ */
+static inline void gpio_toggle_mask(uint32_t port_base, uint16_t mask)
+{
+	uint32_t odr = REG32(port_base + GPIO_ODR_OFFSET);
+	gpio_write_mask(port_base, ~odr & mask, odr & mask);
+}
+
+/**
+ * @brief     Read input level of the pin.
+ * @return    1 if pin is high, 0 if low.
+ */
+static inline uint32_t gpio_read(const gpio_pin_t *pin)
+{
+	return (REG32(pin->port_base + GPIO_IDR_OFFSET) & pin->mask) != 0;
+}
+
+#endif /* GPIO_H_ */
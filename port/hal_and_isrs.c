@@ -8,9 +8,16 @@
 #include "common.h"
 #include "scheduler.h"
 #include "hal_and_isrs.h"
+#include "binlog.h"
+#if CONFIG_SW_TIMERS
+#include "sw_timer.h"
+#endif
+#if CONFIG_PROFILER
+#include "profiler.h"
+#endif
 
 void printf_func(const char *func) {
-	printf("%s\n", func);
+	LOG("%s", func);
 }
 
 struct USFR_err_info {
@@ -61,7 +68,7 @@ static void dump_stack_frame(uint32_t *pBaseStackFrame) {
 	for (int i = 0; i < n_items; i++) { // 0 .. 7
 		offset = ((n_items - 1) - i);   // 7 .. 0
 		uint32_t val = pBaseStackFrame[offset];
-		printf("\t%s %p: %lx\n", stack_dump_msgs[i], &pBaseStackFrame[offset], val);
+		LOG("\t%s %p: %lx", stack_dump_msgs[i], &pBaseStackFrame[offset], val);
 	}
 }
 
@@ -79,18 +86,18 @@ static void UsageFault_Handler_c(uint32_t *pBaseStackFrame) {
 
 	volatile uint32_t *status = (void *)(SCB_USFR);
 	uint16_t status_val = (*status) & (0xFFFF);
-	printf("Exception: Usage FAULT\n");
-	printf("Status: %x\n", status_val); // only 16 bits LBS are used
+	LOG("Exception: Usage FAULT");
+	LOG("Status: %x", status_val); // only 16 bits LBS are used
 	int known_status = 0;
 	for (int i = 0; i < N_USFR_err_info_codes; i++ ) {
 		if ((1 << USFR_err_info_map[i].code) == status_val) {
 			known_status = 1;
-			printf("%s\n", USFR_err_info_map[i].msg);
+			LOG("%s", USFR_err_info_map[i].msg);
 			break;
 		}
 	}
 	if (known_status == 0) {
-		printf("Unknown error\n");
+		LOG("Unknown error");
 	}
 	dump_stack_frame(pBaseStackFrame);
 	while(1);
@@ -115,6 +122,53 @@ void schedule(void)
 	*pICSR |= (1 << SCB_ICSR_PEND_SV_EN_BIT);
 }
 
+/**
+ * @brief     Enable peripheral interrupt in NVIC
+ * @param[in] irq_num - IRQ number (position in vector table after 16 system exceptions)
+ */
+void nvic_enable_irq(uint32_t irq_num)
+{
+	volatile uint32_t *pISER = (void *)(NVIC_ISER_BASE + 4 * (irq_num / 32));
+	*pISER = (1 << (irq_num % 32)); // writing 0 has no effect, so no read-modify-write needed
+}
+
+/**
+ * @brief  Check if CPU is currently executing an exception handler (IPSR != 0)
+ * @return 1 in Handler mode, 0 in Thread mode
+ */
+uint32_t is_in_handler_mode(void)
+{
+	uint32_t ipsr;
+	__asm volatile ("MRS %0, IPSR" : "=r" (ipsr));
+	return (ipsr & 0x1FF) != 0;
+}
+
+/**
+ * @brief  Copy vector table to SRAM and point VTOR to it.
+ */
+void relocate_vector_table_to_sram(void)
+{
+	extern uint32_t vectors[];
+	// VTOR needs the table aligned to its size rounded up to a power of 2:
+	static uint32_t ram_vectors[128] __attribute__((aligned(512)));
+	volatile uint32_t *pVTOR = (void *)(SCB_VTOR);
+	for (uint32_t i = 0; i < VECTOR_TABLE_WORDS; i++)
+		ram_vectors[i] = vectors[i];
+	*pVTOR = (uint32_t)ram_vectors;
+	__asm volatile ("DSB" ::: "memory");
+}
+
+/**
+ * @brief  Start DWT CPU cycle counter (used for benchmarks and profiling).
+ */
+void dwt_cycle_counter_enable(void)
+{
+	volatile uint32_t *pDEMCR = (void *)(DEMCR);
+	volatile uint32_t *pDWT_CTRL = (void *)(DWT_CTRL);
+	*pDEMCR |= (1 << DEMCR_TRCENA_BIT);
+	*pDWT_CTRL |= (1 << DWT_CTRL_CYCCNTENA_BIT);
+}
+
 /**
  * @brief Change current stack pointer from MSP to PSP of current task.
  *        Requires "uint32_t *get_psp_of_current_task(void);" function
@@ -149,6 +203,25 @@ void initial_systick_config(void)
 	*pControl |= ((1 << SYSTICK_CSR_ENABLE_BIT) | (1 << SYSTICK_CSR_ENABLE_INTERRUPT_BIT) | (1 << SYSTICK_CSR_CLKSOURCE_BIT));
 }
 
+/**
+ * @brief     Keep the tick period after the CPU clock changed from "old_hz" to "new_hz". The current tick ends
+ *            after its remaining time, rescaled to the new clock, so no tick is lost or stretched. Must be called
+ *            with interrupts disabled, right after the clock switch.
+ * @param[in] counts_left - SysTick CVR read just before the switch.
+ */
+void systick_change_clock(uint32_t counts_left, uint32_t old_hz, uint32_t new_hz)
+{
+	uint32_t left = (uint32_t)(((uint64_t)counts_left * new_hz) / old_hz);
+	if (left < 16U)
+		left = 16U;	// tick about to expire: let it fire right after the reload
+	volatile uint32_t *pResetVal = (void *)(SYSTICK_RVR);
+	volatile uint32_t *pCurrentVal = (void *)(SYSTICK_CVR);
+	*pResetVal = left;
+	*pCurrentVal = 0;				// any write clears the counter, it reloads from RVR on the next clock
+	while (*pCurrentVal == 0);
+	*pResetVal = (new_hz / CONFIG_TICK_RATE_HZ) - 1;	// used from the next tick on
+}
+
 /**
  * @brief     Put initial scheduler stack value to MSP (Main stack pointer)
  * @param[in] start_of_stack - starting address of memory region allocated for scheduler stack.
@@ -232,16 +305,61 @@ __attribute((naked)) void PendSV_Handler(void)
 }
 
 /**
- * @brief Triggered by SysTick timer every TASK_DURATION interval. Implements scheduler tick.
+ * @brief Scheduler tick, body of SysTick_Handler.
  */
-void SysTick_Handler(void)
+void systick_tick(void)
 {
+#if CONFIG_HW_COUNTERS
+	harvest_hw_counters();	// a task can run for many ticks without a switch
+#endif
 	update_global_tick_count();
-	update_blocked_tasks();
+#if CONFIG_SW_TIMERS
+	sw_timer_check_expired(get_tick_count());
+#endif
+#if CONFIG_SCHED_POLICY == SCHED_POLICY_CYCLIC
+	// Table-driven: no scheduling decisions, a context switch at the frame boundary or when the frame owner's
+	// task_wait_notify() timed out
+	uint32_t switch_due = update_blocked_tasks();
+	if (cyclic_advance_frame() || switch_due)
+		schedule();
+#else
+	// Set PendSV handler bit only if a task was released or the running one has to share the CPU:
+	uint32_t switch_due = update_blocked_tasks();
+#if CONFIG_TASK_BUDGETS
+	switch_due |= update_task_budgets();	// throttled tasks released, running one out of budget
+#endif
+	if (switch_due || is_time_slice_due())
+		schedule();
+#endif
+}
 
-	// Set PendSV handler bit:
-	schedule();
+#if CONFIG_PROFILER
+/**
+ * @brief Triggered by SysTick timer CONFIG_TICK_RATE_HZ times per second. Samples the PC of the interrupted code
+ *        for the profiler and runs the scheduler tick.
+ */
+__attribute((naked)) void SysTick_Handler(void)
+{
+	// Exception frame of the interrupted code is on PSP for tasks (EXC_RETURN bit 2 set) and on MSP for handlers:
+	__asm volatile ("TST LR, #4");
+	__asm volatile ("ITE EQ");
+	__asm volatile ("MRSEQ R0, MSP");
+	__asm volatile ("MRSNE R0, PSP");
+	__asm volatile ("MOV R1, LR");
+	__asm volatile ("PUSH {R4, LR}");	// R4 keeps the stack 8-byte aligned
+	__asm volatile ("BL profiler_sample");
+	__asm volatile ("BL systick_tick");
+	__asm volatile ("POP {R4, PC}");	// PC = EXC_RETURN: return from exception
 }
+#else
+/**
+ * @brief Triggered by SysTick timer CONFIG_TICK_RATE_HZ times per second. Implements scheduler tick.
+ */
+void SysTick_Handler(void)
+{
+	systick_tick();
+}
+#endif /* CONFIG_PROFILER */
 
 /**
  * @brief Fault handler with priority -1 in case of:
@@ -271,6 +389,6 @@ void MemManage_Handler(void) {
  *          bus device is not ready)
  */
 void BusFault_Handler(void) {
-	printf(__func__);
+	printf_func(__func__);
 	while(1);
 }
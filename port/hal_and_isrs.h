@@ -9,18 +9,25 @@
 #define HAL_AND_ISRS_H_
 #include "common.h"
 
-#define CPU_CLOCK_RATE (16 * 1000000) 	// 16 MHz, internal processor clock used (HSI)
+#define CPU_CLOCK_RATE CONFIG_CPU_CLOCK_HZ
+// Clocks of APB1 peripherals (TIM2, TIM3, USART2). With CONFIG_DVFS the APB1 prescaler follows the AHB clock
+// (port/dvfs.c), so they are the same at every operating point. Timers get 2 x APB1 clock if APB1 prescaler > 1:
+#if CONFIG_DVFS
+#define APB1_CLOCK_RATE (CPU_CLOCK_RATE / 2U)
+#else
+#define APB1_CLOCK_RATE CPU_CLOCK_RATE
+#endif
+#define APB1_TIMER_CLOCK_RATE CPU_CLOCK_RATE
 #define SRAM_START (0x20000000)
 #define SRAM_SIZE (256U * 1024U)
 #define SRAM_END (SRAM_START + SRAM_SIZE) //20040000
 
-// Num tasks should match MAX_TASKS in common.h:
-#define TASK_1_STACK_START (SRAM_END - 0 * TASK_STACK_SIZE_B)
-#define TASK_2_STACK_START (SRAM_END - 1 * TASK_STACK_SIZE_B)
-#define TASK_3_STACK_START (SRAM_END - 2 * TASK_STACK_SIZE_B)
-#define TASK_4_STACK_START (SRAM_END - 3 * TASK_STACK_SIZE_B)
-#define TASK_IDLE_STACK_START (SRAM_END - 4 * TASK_STACK_SIZE_B)
-#define SCHEDULER_STACK_START (SRAM_END - 5 * TASK_STACK_SIZE_B)
+// SRAM layout from the top: boot stack (main) | scheduler (MSP) stack | heap growing up from "end".
+// Task stacks are statically allocated arrays in .bss, see KERNEL_TASK_LIST in kernel_config.h.
+#define SCHEDULER_STACK_START (SRAM_END - CONFIG_BOOT_STACK_SIZE_B)
+#define HEAP_END (SCHEDULER_STACK_START - SCHEDULER_STACK_SIZE_B) // malloc heap grows from "end" (linker) up to here
+
+#define STACK_CANARY (0xDEADBEEFU)	// Written to the lowest word of every task stack when CONFIG_STACK_CHECK is on
 
 /* ============= SCB (System Control Block ================ */
 // FAULT regs:
@@ -39,10 +46,18 @@
 # define SCB_MEMMANAGE_FAULT_EN_BIT (16)
 # define SCB_BUS_FAULT_EN_BIT (17)
 
+// Vector Table Offset Register:
+#define SCB_VTOR (0xE000ED08)
+#define VECTOR_TABLE_WORDS (16U + 97U)	// system exceptions + STM32F412 IRQs
+
 // System Control Block - Interrupt Control Status Register
 #define SCB_ICSR (0xE000ED04)
 #define SCB_ICSR_PEND_SV_EN_BIT (28)
 
+/* ============= NVIC (Nested Vectored Interrupt Controller) ================ */
+#define NVIC_ISER_BASE (0xE000E100)		// Interrupt Set-Enable Registers, 32 IRQs per register
+#define NVIC_ICER_BASE (0xE000E180)		// Interrupt Clear-Enable Registers
+
 /* ============= SysTick - System Timer =================== */
 // CSR - Control State Register:
 #define SYSTICK_CSR (0xE000E010)
@@ -52,7 +67,16 @@
 
 // RVR - Reset Value Register:
 #define SYSTICK_RVR (0xE000E014)
-#define SYSTICK_RESET_VAL ((CPU_CLOCK_RATE / TASK_DURATION) - 1) // -1 because the exception happens when switching from 0 to RESET_VAL
+#define SYSTICK_CVR (0xE000E018)
+#define SYSTICK_RESET_VAL ((CPU_CLOCK_RATE / CONFIG_TICK_RATE_HZ) - 1) // -1 because the exception happens when switching from 0 to RESET_VAL
+
+/* ============= DWT (Data Watchpoint and Trace) ========== */
+#define DEMCR (0xE000EDFC)				// Debug Exception and Monitor Control Register
+#define DEMCR_TRCENA_BIT (24)			// enables DWT
+#define DWT_CTRL (0xE0001000)
+#define DWT_CTRL_CYCCNTENA_BIT (0)
+#define DWT_CYCCNT (0xE0001004)			// CPU clock cycle counter
+// 8-bit event counters, each one increments on every cycle of its kind and wraps at 256:
 
 /* =========================================================*/
 
@@ -68,6 +92,9 @@
 // Use PRIMASK register to disable all interrupts for critical sections:
 #define INTERRUPT_DISABLE() do {__asm volatile ("MOV R0, #0x01"); __asm volatile ("MSR PRIMASK, R0");} while(0);
 #define INTERRUPT_ENABLE() do {__asm volatile ("MOV R0, #0x0"); __asm volatile ("MSR PRIMASK, R0");} while(0);
+// Nestable variant, safe to use in ISRs and inside other critical sections. "state" is uint32_t variable:
+#define INTERRUPT_SAVE_AND_DISABLE(state) do {__asm volatile ("MRS %0, PRIMASK\n\tCPSID i" : "=r" (state) :: "memory");} while(0);
+#define INTERRUPT_RESTORE(state) do {__asm volatile ("MSR PRIMASK, %0" :: "r" (state) : "memory");} while(0);
 
 /**
  * @brief Enable all System Fault handlers (Usage, Memory, Bus)
@@ -79,6 +106,42 @@ void enable_all_configurable_exceptions(void);
  */
 void schedule(void);
 
+/**
+ * @brief     Enable peripheral interrupt in NVIC
+ * @param[in] irq_num - IRQ number (position in vector table after 16 system exceptions)
+ */
+void nvic_enable_irq(uint32_t irq_num);
+
+/**
+ * @brief  Check if CPU is currently executing an exception handler (IPSR != 0)
+ * @return 1 in Handler mode, 0 in Thread mode
+ */
+uint32_t is_in_handler_mode(void);
+
+/**
+ * @brief  Scheduler tick: tick counter, software timers, release of delayed tasks. Called by SysTick_Handler.
+ */
+void systick_tick(void);
+
+/**
+ * @brief  Copy vector table to SRAM and point VTOR to it, so exception entry doesn't read flash (flash reads
+ *         stall during flash erase/program).
+ */
+void relocate_vector_table_to_sram(void);
+
+/**
+ * @brief  Start DWT CPU cycle counter (used for benchmarks and profiling).
+ */
+void dwt_cycle_counter_enable(void);
+
+/**
+ * @brief  Get CPU cycles counted since dwt_cycle_counter_enable(), wraps every 2^32 cycles.
+ */
+static inline uint32_t dwt_get_cycles(void)
+{
+	return *(volatile uint32_t *)DWT_CYCCNT;
+}
+
 /**
  * @brief Change current stack pointer from MSP to PSP of current task.
  *        Requires "uint32_t *get_psp_of_current_task(void);" function
@@ -89,6 +152,7 @@ __attribute((naked)) void change_sp_to_psp(void);
  * @brief Init SysTick timer and enable the interrupt
  */
 void initial_systick_config(void);
+void systick_change_clock(uint32_t counts_left, uint32_t old_hz, uint32_t new_hz);
 
 /**
  * @brief     Put initial scheduler stack value to MSP (Main stack pointer)
@@ -0,0 +1,190 @@
+/*
+ * stm32f412_periph.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef STM32F412_PERIPH_H_
+#define STM32F412_PERIPH_H_
+#include <stdint.h>
+
+#define REG32(addr) (*(volatile uint32_t *)(addr))
+
+/* ============= Bus base addresses ======================= */
+#define APB1_BASE (0x40000000U)
+#define APB2_BASE (0x40010000U)
+#define AHB1_BASE (0x40020000U)
+
+/* ============= RCC - Reset and clock control ============ */
+#define RCC_BASE (AHB1_BASE + 0x3800)
+#define RCC_CR (RCC_BASE + 0x00)
+#define RCC_PLLCFGR (RCC_BASE + 0x04)
+#define RCC_CFGR (RCC_BASE + 0x08)
+#define RCC_AHB1ENR (RCC_BASE + 0x30)
+#define RCC_APB1ENR (RCC_BASE + 0x40)
+#define RCC_APB2ENR (RCC_BASE + 0x44)
+
+#define RCC_AHB1ENR_GPIOAEN_BIT (0)		// GPIOxEN bit number equals to port index (A = 0 ... H = 7)
+#define RCC_AHB1ENR_DMA1EN_BIT (21)
+#define RCC_AHB1ENR_DMA2EN_BIT (22)
+#define RCC_APB1ENR_TIM2EN_BIT (0)
+#define RCC_APB1ENR_TIM3EN_BIT (1)
+#define RCC_APB1ENR_USART2EN_BIT (17)
+
+#define RCC_CR_PLLON_BIT (24)
+#define RCC_CR_PLLRDY_BIT (25)
+
+#define RCC_PLLCFGR_PLLM_POS (0)		// VCO input = PLL source / M, 1..2 MHz
+#define RCC_PLLCFGR_PLLN_POS (6)		// VCO = VCO input * N, 100..432 MHz
+#define RCC_PLLCFGR_PLLP_POS (16)		// SYSCLK = VCO / P, 00: 2, 01: 4, 10: 6, 11: 8
+#define RCC_PLLCFGR_PLLSRC_BIT (22)		// 0: HSI
+#define RCC_PLLCFGR_PLLQ_POS (24)
+#define RCC_PLLCFGR_PLLR_POS (28)
+
+#define RCC_CFGR_SW_POS (0)
+#define RCC_CFGR_SWS_POS (2)
+#define RCC_CFGR_SW_HSI (0U)
+#define RCC_CFGR_SW_PLL (2U)
+#define RCC_CFGR_HPRE_POS (4)			// AHB prescaler, 0xxx: 1, 1000: 2, 1001: 4, 1010: 8
+#define RCC_CFGR_HPRE_DIV1 (0x0U)
+#define RCC_CFGR_HPRE_DIV2 (0x8U)
+#define RCC_CFGR_PPRE1_POS (10)			// APB1 prescaler, 0xx: 1, 100: 2, 101: 4, 110: 8
+#define RCC_CFGR_PPRE1_DIV2 (0x4U)
+#define RCC_CFGR_PPRE1_DIV4 (0x5U)
+#define RCC_CFGR_PPRE1_DIV8 (0x6U)
+#define RCC_CFGR_CLOCK_MASK ((0x3U << RCC_CFGR_SW_POS) | (0xFU << RCC_CFGR_HPRE_POS) | (0x7U << RCC_CFGR_PPRE1_POS))
+
+/* ============= GPIO ===================================== */
+#define GPIOX_OFFSET (0x400U)
+#define GPIO_PORT_A (0U)
+#define GPIO_PORT_B (1U)
+#define GPIO_PORT_C (2U)
+#define GPIO_PORT_D (3U)
+#define GPIO_PORT_E (4U)
+#define GPIO_PORT_F (5U)
+#define GPIO_PORT_G (6U)
+#define GPIO_PORT_H (7U)
+#define GPIO_PORT_BASE(port) (AHB1_BASE + (port) * GPIOX_OFFSET)
+#define GPIOA_BASE GPIO_PORT_BASE(GPIO_PORT_A)
+#define GPIO_MODER_OFFSET (0x00)
+#define GPIO_OTYPER_OFFSET (0x04)
+#define GPIO_IDR_OFFSET (0x10)
+#define GPIO_ODR_OFFSET (0x14)
+#define GPIO_BSRR_OFFSET (0x18)		// bits 0..15 set pins, bits 16..31 reset pins, in a single write
+#define GPIO_AFRL_OFFSET (0x20)
+#define GPIO_AFRH_OFFSET (0x24)
+
+#define GPIO_MODE_INPUT (0x0U)
+#define GPIO_MODE_OUTPUT (0x1U)
+#define GPIO_MODE_AF (0x2U)
+#define GPIO_MODE_ANALOG (0x3U)
+
+/* ============= USART ==================================== */
+#define USART2_BASE (APB1_BASE + 0x4400)
+#define USART_SR_OFFSET (0x00)
+#define USART_DR_OFFSET (0x04)
+#define USART_BRR_OFFSET (0x08)
+#define USART_CR1_OFFSET (0x0C)
+#define USART_CR3_OFFSET (0x14)
+
+#define USART_SR_TC_BIT (6)
+#define USART_CR1_UE_BIT (13)
+#define USART_CR1_TE_BIT (3)
+#define USART_CR3_DMAT_BIT (7)
+
+/* ============= General-purpose timers (TIM2..TIM5) ====== */
+#define TIM2_BASE (APB1_BASE + 0x0000)		// 32-bit counter
+#define TIM3_BASE (APB1_BASE + 0x0400)		// 16-bit counter
+#define TIM_CR1_OFFSET (0x00)
+#define TIM_DIER_OFFSET (0x0C)
+#define TIM_SR_OFFSET (0x10)
+#define TIM_EGR_OFFSET (0x14)
+#define TIM_CNT_OFFSET (0x24)
+#define TIM_PSC_OFFSET (0x28)
+#define TIM_ARR_OFFSET (0x2C)
+#define TIM_CCR1_OFFSET (0x34)
+
+#define TIM_CR1_CEN_BIT (0)
+#define TIM_DIER_UIE_BIT (0)
+#define TIM_DIER_CC1IE_BIT (1)
+#define TIM_SR_UIF_BIT (0)
+#define TIM_SR_CC1IF_BIT (1)		// rc_w0: cleared by writing 0, writing 1 has no effect
+#define TIM_EGR_UG_BIT (0)
+#define TIM_EGR_CC1G_BIT (1)		// software compare event, sets CC1IF
+
+/* ============= DMA ====================================== */
+#define DMA1_BASE (AHB1_BASE + 0x6000)
+#define DMA2_BASE (AHB1_BASE + 0x6400)
+#define DMA_LISR_OFFSET (0x00)		// streams 0..3 flags
+#define DMA_HISR_OFFSET (0x04)		// streams 4..7 flags
+#define DMA_LIFCR_OFFSET (0x08)
+#define DMA_HIFCR_OFFSET (0x0C)
+
+// Stream registers:
+#define DMA_STREAM_BASE(dma, n) ((dma) + 0x10 + 0x18 * (n))
+#define DMA_SxCR_OFFSET (0x00)
+#define DMA_SxNDTR_OFFSET (0x04)
+#define DMA_SxPAR_OFFSET (0x08)
+#define DMA_SxM0AR_OFFSET (0x0C)
+#define DMA_SxFCR_OFFSET (0x14)
+
+#define DMA_SxCR_EN_BIT (0)
+#define DMA_SxCR_TEIE_BIT (2)
+#define DMA_SxCR_TCIE_BIT (4)
+#define DMA_SxCR_DIR_POS (6)		// 00: periph->mem, 01: mem->periph, 10: mem->mem
+#define DMA_SxCR_PINC_BIT (9)
+#define DMA_SxCR_MINC_BIT (10)
+#define DMA_SxCR_PSIZE_POS (11)		// 00: byte, 01: half-word, 10: word
+#define DMA_SxCR_MSIZE_POS (13)
+#define DMA_SIZE_BYTE (0x0U)
+#define DMA_SIZE_WORD (0x2U)
+#define DMA_DIR_MEM_TO_MEM (0x2U)		// DMA2 only, peripheral port is the source
+#define DMA_SxCR_CHSEL_POS (25)
+
+#define DMA_SxFCR_FTH_FULL (0x3U)
+#define DMA_SxFCR_DMDIS_BIT (2)
+
+// Stream flags position inside its LISR/HISR register, each stream has 6 flags:
+#define DMA_FLAGS_POS(n) ((((n) & 1) ? 6 : 0) + (((n) & 2) ? 16 : 0))
+#define DMA_FLAG_TCIF (1U << 5)
+#define DMA_FLAG_TEIF (1U << 3)
+#define DMA_FLAGS_ALL (0x3DU)
+
+/* ============= FLASH interface ========================== */
+#define FLASH_IF_BASE (AHB1_BASE + 0x3C00)
+#define FLASH_ACR_OFFSET (0x00)
+#define FLASH_KEYR_OFFSET (0x04)
+#define FLASH_SR_OFFSET (0x0C)
+#define FLASH_CR_OFFSET (0x10)
+
+#define FLASH_KEY1 (0x45670123U)
+#define FLASH_KEY2 (0xCDEF89ABU)
+
+#define FLASH_ACR_LATENCY_MASK (0xFU)	// wait states, 2.7 - 3.6 V: 0 up to 30 MHz, 1 up to 64 MHz
+#define FLASH_ACR_DCEN_BIT (10)
+#define FLASH_ACR_DCRST_BIT (12)
+
+#define FLASH_SR_EOP_BIT (0)
+#define FLASH_SR_BSY_BIT (16)
+#define FLASH_SR_ERRORS (0x1F2U)		// OPERR, WRPERR, PGAERR, PGPERR, PGSERR, RDERR; rc_w1
+
+#define FLASH_CR_PG_BIT (0)
+#define FLASH_CR_SER_BIT (1)
+#define FLASH_CR_SNB_POS (3)
+#define FLASH_CR_PSIZE_POS (8)			// 10: word, needs 2.7 - 3.6 V supply
+#define FLASH_CR_STRT_BIT (16)
+#define FLASH_CR_EOPIE_BIT (24)
+#define FLASH_CR_ERRIE_BIT (25)
+#define FLASH_CR_LOCK_BIT (31)
+
+#define FLASH_PSIZE_WORD (0x2U)
+
+/* ============= IRQ numbers ============================== */
+#define IRQ_NUM_FLASH (4)
+#define IRQ_NUM_DMA1_STREAM6 (17)
+#define IRQ_NUM_TIM2 (28)
+#define IRQ_NUM_TIM3 (29)
+#define IRQ_NUM_DMA2_STREAM0 (56)
+
+#endif /* STM32F412_PERIPH_H_ */
@@ -56,6 +56,8 @@
 #include <time.h>
 #include <sys/time.h>
 #include <sys/times.h>
+#include "hal_and_isrs.h"
+#include "uart_dma.h"
 
 /* Variables */
 //#undef errno
@@ -63,8 +65,6 @@ extern int errno;
 extern int __io_putchar(int ch) __attribute__((weak));
 extern int __io_getchar(void) __attribute__((weak));
 
-register char * stack_ptr asm("sp");
-
 char *__env[1] = { 0 };
 char **environ = __env;
 
@@ -106,14 +106,18 @@ return len;
 
 __attribute__((weak)) int _write(int file, char *ptr, int len)
 {
+#if CONFIG_UART_DMA
+	// Only copies data to TX ring buffer, transmission is done by DMA in background
+	return uart_dma_write(ptr, len);
+#else
 	int DataIdx;
 
 	for (DataIdx = 0; DataIdx < len; DataIdx++)
 	{
 		__io_putchar(*ptr++);
-		//ITM_SendChar(*ptr++);
 	}
 	return len;
+#endif /* CONFIG_UART_DMA */
 }
 
 int _close(int file)
@@ -189,7 +193,9 @@ int _execve(char *name, char **argv, char **env)
 
 /**
  _sbrk
- Increase program data space. Malloc and related functions depend on this
+ Increase program data space. Malloc and related functions depend on this.
+ Heap is limited by HEAP_END instead of current SP: after the scheduler starts SP is PSP of some task
+ stack, which says nothing about the heap limit.
 **/
 caddr_t _sbrk(int incr)
 {
@@ -201,7 +207,7 @@ caddr_t _sbrk(int incr)
 		heap_end = &end;
 
 	prev_heap_end = heap_end;
-	if (heap_end + incr > stack_ptr)
+	if (heap_end + incr > (char *)HEAP_END)
 	{
 		errno = ENOMEM;
 		return (caddr_t) -1;
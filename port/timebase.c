@@ -0,0 +1,145 @@
+/*
+ * timebase.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+#include "kernel_config.h"
+#if CONFIG_HR_TIMEBASE
+#include "timebase.h"
+#include "scheduler.h"
+#include "hal_and_isrs.h"
+#include "stm32f412_periph.h"
+
+_Static_assert(MAX_TASKS <= 32, "Waiting mask holds one bit per task");
+
+// TIM2 is on APB1, its clock stays the same when CONFIG_DVFS changes the CPU clock
+#define TB_TIM_BASE TIM2_BASE
+#define TB_PRESCALER ((APB1_TIMER_CLOCK_RATE / TIMEBASE_HZ) - 1)
+
+/* ======================== GLOBAL STATE ==================================*/
+static uint32_t wake_us[MAX_TASKS];				// wakeup timestamp of every sleeping task
+static volatile uint32_t expired[MAX_TASKS];	// wake flag for task_suspend_until()
+static uint32_t waiting = 0;					// bit "task_id" is set while the task sleeps in delay_us()
+
+/* ========================================================================*/
+
+/**
+ * @brief Program compare channel to the earliest wakeup. Must be called with interrupts disabled.
+ */
+static void arm_next_compare(void)
+{
+	uint32_t mask = waiting;
+	if (mask == 0) {
+		REG32(TB_TIM_BASE + TIM_DIER_OFFSET) &= ~(1U << TIM_DIER_CC1IE_BIT);
+		return;
+	}
+	uint32_t now = kernel_now_us();
+	uint32_t next = wake_us[__builtin_ctz(mask)];
+	while (mask != 0) {
+		uint32_t task_id = __builtin_ctz(mask);
+		mask &= mask - 1;
+		if ((int32_t)(wake_us[task_id] - now) < (int32_t)(next - now))
+			next = wake_us[task_id];
+	}
+	REG32(TB_TIM_BASE + TIM_CCR1_OFFSET) = next;
+	REG32(TB_TIM_BASE + TIM_SR_OFFSET) = ~(1U << TIM_SR_CC1IF_BIT);
+	REG32(TB_TIM_BASE + TIM_DIER_OFFSET) |= (1U << TIM_DIER_CC1IE_BIT);
+	// Compare matches only when the counter reaches CCR1, so a wakeup which is already due is forced by software:
+	if ((int32_t)(next - kernel_now_us()) <= 0)
+		REG32(TB_TIM_BASE + TIM_EGR_OFFSET) = (1U << TIM_EGR_CC1G_BIT);
+}
+
+/* Suspend current task till TIM2 compare reaches "wake" */
+static void sleep_until(uint32_t wake)
+{
+	uint32_t task_id = get_current_task_id();
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	wake_us[task_id] = wake;
+	expired[task_id] = 0;
+	waiting |= (1U << task_id);
+	arm_next_compare();
+	INTERRUPT_RESTORE(state);
+	task_suspend_until(&expired[task_id]);
+}
+
+/* Short delays and contexts which can't be suspended spin on the counter */
+static inline uint32_t must_busy_wait(uint32_t us)
+{
+	return us < CONFIG_HR_MIN_SLEEP_US || !is_scheduler_running() || is_in_handler_mode() ||
+			get_current_task_id() == IDLE_TASK_ID;
+}
+
+/**
+ * @brief     Start TIM2 counting microseconds and enable its interrupt for delay_us().
+ */
+void timebase_init(void)
+{
+	REG32(RCC_APB1ENR) |= (1 << RCC_APB1ENR_TIM2EN_BIT);
+	REG32(TB_TIM_BASE + TIM_CR1_OFFSET) &= ~(1U << TIM_CR1_CEN_BIT);
+	REG32(TB_TIM_BASE + TIM_PSC_OFFSET) = TB_PRESCALER;
+	REG32(TB_TIM_BASE + TIM_ARR_OFFSET) = 0xFFFFFFFFU;
+	REG32(TB_TIM_BASE + TIM_CNT_OFFSET) = 0;
+	REG32(TB_TIM_BASE + TIM_EGR_OFFSET) = (1U << TIM_EGR_UG_BIT);	// prescaler is loaded on update event only
+	REG32(TB_TIM_BASE + TIM_SR_OFFSET) = 0;
+	REG32(TB_TIM_BASE + TIM_CR1_OFFSET) |= (1U << TIM_CR1_CEN_BIT);
+	nvic_enable_irq(IRQ_NUM_TIM2);
+}
+
+uint32_t kernel_now_us(void)
+{
+	return REG32(TB_TIM_BASE + TIM_CNT_OFFSET);
+}
+
+/**
+ * @brief     Sleep for at least "us" microseconds.
+ */
+void delay_us(uint32_t us)
+{
+	uint32_t start = kernel_now_us();
+	if (must_busy_wait(us)) {
+		while (kernel_now_us() - start < us);
+		return;
+	}
+	sleep_until(start + us);
+}
+
+/**
+ * @brief     Sleep till *last_wake + period_us and advance *last_wake by the period.
+ */
+void delay_until_us(uint32_t *last_wake, uint32_t period_us)
+{
+	uint32_t wake = *last_wake + period_us;
+	*last_wake = wake;
+	int32_t left = (int32_t)(wake - kernel_now_us());
+	if (left <= 0)
+		return;
+	if (must_busy_wait((uint32_t)left)) {
+		while ((int32_t)(wake - kernel_now_us()) > 0);
+		return;
+	}
+	sleep_until(wake);
+}
+
+/**
+ * @brief TIM2 compare: resume every task whose wakeup time has come and program the next one.
+ */
+void TIM2_IRQHandler(void)
+{
+	REG32(TB_TIM_BASE + TIM_SR_OFFSET) = ~(1U << TIM_SR_CC1IF_BIT);
+	uint32_t now = kernel_now_us();
+	uint32_t mask = waiting;
+	while (mask != 0) {
+		uint32_t task_id = __builtin_ctz(mask);
+		mask &= mask - 1;
+		if ((int32_t)(wake_us[task_id] - now) <= 0) {
+			waiting &= ~(1U << task_id);
+			expired[task_id] = 1;
+			task_resume(task_id);
+		}
+	}
+	arm_next_compare();
+}
+
+#endif /* CONFIG_HR_TIMEBASE */
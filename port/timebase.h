@@ -0,0 +1,46 @@
+/*
+ * timebase.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+#include "common.h"
+
+/*
+ * High-resolution timebase: TIM2 is a free running 32-bit counter clocked at 1 MHz, so timestamps have 1 us
+ * resolution and wrap after ~71.6 minutes. Compare differences of timestamps ((int32_t)(a - b)), not the values.
+ * Microsecond sleeps use the TIM2 compare channel 1 interrupt, independent of the scheduler tick.
+ */
+
+#define TIMEBASE_HZ (1000000U)
+
+/**
+ * @brief     Start TIM2 counting microseconds and enable its interrupt for delay_us().
+ */
+void timebase_init(void);
+
+/**
+ * @brief     Get current timestamp. Can be called from ISR.
+ * @return    microseconds since timebase_init(), modulo 2^32.
+ */
+uint32_t kernel_now_us(void);
+
+/**
+ * @brief     Sleep for at least "us" microseconds. Delays shorter than CONFIG_HR_MIN_SLEEP_US (and any delay in
+ *            ISR, idle task or before scheduler start) busy-wait, longer ones suspend the task till TIM2 compare.
+ * @param[in] us - microseconds to sleep, less than 2^31.
+ */
+void delay_us(uint32_t us);
+
+/**
+ * @brief     Sleep till *last_wake + period_us and advance *last_wake by the period, so a periodic task doesn't
+ *            drift by its own execution time. Returns at once if that time has already passed.
+ * @param[in,out] last_wake - timestamp of the previous wakeup, initialize with kernel_now_us().
+ * @param[in] period_us - period in microseconds.
+ */
+void delay_until_us(uint32_t *last_wake, uint32_t period_us);
+
+#endif /* TIMEBASE_H_ */
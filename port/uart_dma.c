@@ -0,0 +1,200 @@
+/*
+ * uart_dma.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+#include "kernel_config.h"
+#if CONFIG_UART_DMA
+#include <string.h>
+#include "uart_dma.h"
+#include "scheduler.h"
+#include "hal_and_isrs.h"
+#include "stm32f412_periph.h"
+
+#define UART_TX_PIN (2)				// PA2
+#define UART_TX_PIN_AF (7)			// AF7 = USART2
+#define UART_DMA_STREAM (6)			// DMA1 Stream6 Channel4 = USART2_TX
+#define UART_DMA_CHANNEL (4)
+
+#define UART_DMA_STREAM_BASE DMA_STREAM_BASE(DMA1_BASE, UART_DMA_STREAM)
+
+/* ======================== GLOBAL STATE ==================================*/
+static char tx_buf[UART_TX_BUF_SIZE];
+static volatile uint32_t tx_head = 0;		// end of published data, free running counter
+static volatile uint32_t tx_reserve = 0;	// end of space reserved by writers, free running counter
+static volatile uint32_t tx_writers = 0;	// writers copying into reserved space
+static volatile uint32_t tx_tail = 0;		// next byte to send, free running counter
+static volatile uint32_t dma_len = 0;		// bytes currently transferred by DMA, 0 - DMA is idle
+static uint32_t dropped = 0;
+static uart_overflow_policy_t overflow_policy = UART_OVERFLOW_DROP;
+
+/* ========================================================================*/
+
+/**
+ * @brief Start DMA transfer of the contiguous part of pending data. Must be called with interrupts disabled.
+ */
+static void start_dma_if_idle(void)
+{
+	uint32_t pending = tx_head - tx_tail;
+	uint32_t pos = tx_tail & (UART_TX_BUF_SIZE - 1);
+	if (dma_len != 0 || pending == 0)
+		return;
+
+	// DMA can't wrap around the ring end, so send till the end of buffer and the rest on the next IRQ:
+	dma_len = (pending < UART_TX_BUF_SIZE - pos) ? pending : (UART_TX_BUF_SIZE - pos);
+	REG32(UART_DMA_STREAM_BASE + DMA_SxM0AR_OFFSET) = (uint32_t)&tx_buf[pos];
+	REG32(UART_DMA_STREAM_BASE + DMA_SxNDTR_OFFSET) = dma_len;
+	REG32(DMA1_BASE + DMA_HIFCR_OFFSET) = DMA_FLAGS_ALL << DMA_FLAGS_POS(UART_DMA_STREAM);
+	REG32(UART_DMA_STREAM_BASE + DMA_SxCR_OFFSET) |= (1 << DMA_SxCR_EN_BIT);
+}
+
+/**
+ * @brief Handle DMA completion flags: release space of the finished chunk and start the next one.
+ *        Called from the DMA IRQ, or polled with interrupts disabled when the IRQ can't be taken.
+ */
+static void service_dma(void)
+{
+	uint32_t flags = (REG32(DMA1_BASE + DMA_HISR_OFFSET) >> DMA_FLAGS_POS(UART_DMA_STREAM)) & DMA_FLAGS_ALL;
+	REG32(DMA1_BASE + DMA_HIFCR_OFFSET) = flags << DMA_FLAGS_POS(UART_DMA_STREAM);
+
+	if (flags & (DMA_FLAG_TCIF | DMA_FLAG_TEIF)) {
+		// On transfer error the chunk is lost, count it as dropped and continue with the next one:
+		if (flags & DMA_FLAG_TEIF)
+			dropped += dma_len;
+		tx_tail += dma_len;
+		dma_len = 0;
+		start_dma_if_idle();
+	}
+}
+
+/**
+ * @brief     Configure USART2 TX with DMA1 Stream6 and enable its interrupt.
+ */
+void uart_dma_init(uint32_t baudrate, uart_overflow_policy_t policy)
+{
+	overflow_policy = policy;
+
+	// Clocks: GPIOA, DMA1, USART2
+	REG32(RCC_AHB1ENR) |= (1 << RCC_AHB1ENR_GPIOAEN_BIT) | (1 << RCC_AHB1ENR_DMA1EN_BIT);
+	REG32(RCC_APB1ENR) |= (1 << RCC_APB1ENR_USART2EN_BIT);
+
+	// PA2 to alternate function USART2_TX:
+	REG32(GPIOA_BASE + GPIO_MODER_OFFSET) &= ~(0x3U << (UART_TX_PIN * 2));
+	REG32(GPIOA_BASE + GPIO_MODER_OFFSET) |= (GPIO_MODE_AF << (UART_TX_PIN * 2));
+	REG32(GPIOA_BASE + GPIO_AFRL_OFFSET) &= ~(0xFU << (UART_TX_PIN * 4));
+	REG32(GPIOA_BASE + GPIO_AFRL_OFFSET) |= (UART_TX_PIN_AF << (UART_TX_PIN * 4));
+
+	// USART2 is clocked from APB1, oversampling by 16: BRR = fck / baudrate
+	REG32(USART2_BASE + USART_BRR_OFFSET) = (APB1_CLOCK_RATE + baudrate / 2) / baudrate;
+	REG32(USART2_BASE + USART_CR3_OFFSET) |= (1 << USART_CR3_DMAT_BIT);
+	REG32(USART2_BASE + USART_CR1_OFFSET) |= (1 << USART_CR1_UE_BIT) | (1 << USART_CR1_TE_BIT);
+
+	// DMA stream: memory -> USART2 DR, byte transfers, memory increment, interrupt on transfer complete/error:
+	REG32(UART_DMA_STREAM_BASE + DMA_SxCR_OFFSET) &= ~(1 << DMA_SxCR_EN_BIT);
+	while (REG32(UART_DMA_STREAM_BASE + DMA_SxCR_OFFSET) & (1 << DMA_SxCR_EN_BIT));
+	REG32(UART_DMA_STREAM_BASE + DMA_SxPAR_OFFSET) = USART2_BASE + USART_DR_OFFSET;
+	REG32(UART_DMA_STREAM_BASE + DMA_SxCR_OFFSET) = (UART_DMA_CHANNEL << DMA_SxCR_CHSEL_POS) |
+			(1 << DMA_SxCR_MINC_BIT) | (0x1U << DMA_SxCR_DIR_POS) |
+			(1 << DMA_SxCR_TCIE_BIT) | (1 << DMA_SxCR_TEIE_BIT);
+
+	nvic_enable_irq(IRQ_NUM_DMA1_STREAM6);
+}
+
+/**
+ * @brief     Copy data into TX ring buffer and start DMA if it is idle. Doesn't wait for transmission.
+ * @return    number of bytes queued (less than len if some were dropped)
+ */
+int uart_dma_write(const char *data, int len)
+{
+	int queued = 0;
+	uint32_t state;
+	uint32_t may_block = (overflow_policy == UART_OVERFLOW_BLOCK) &&
+			is_scheduler_running() && !is_in_handler_mode();
+
+	while (queued < len) {
+		// Reserve space under the lock, copy outside of it so interrupts aren't held off for the memcpy:
+		INTERRUPT_SAVE_AND_DISABLE(state);
+		uint32_t space = UART_TX_BUF_SIZE - (tx_reserve - tx_tail);
+		uint32_t pos = tx_reserve & (UART_TX_BUF_SIZE - 1);
+		uint32_t n = (uint32_t)(len - queued);
+		if (n > space)
+			n = space;
+		if (n > UART_TX_BUF_SIZE - pos)
+			n = UART_TX_BUF_SIZE - pos;
+		tx_reserve += n;
+		tx_writers++;
+		INTERRUPT_RESTORE(state);
+
+		memcpy(&tx_buf[pos], data + queued, n);
+		queued += n;
+
+		// Publish only when no other writer (preempted task or ISR) is still copying into its reserved space:
+		INTERRUPT_SAVE_AND_DISABLE(state);
+		if (--tx_writers == 0) {
+			tx_head = tx_reserve;
+			start_dma_if_idle();
+		}
+		INTERRUPT_RESTORE(state);
+
+		if (n == 0) {
+			if (!may_block) {
+				dropped += len - queued;
+				break;
+			}
+			delay_task(1); // let DMA free some space
+		}
+	}
+	return queued;
+}
+
+/**
+ * @brief     Wait till all queued bytes are physically transmitted. Busy-waits when called from ISR, before the
+ *            scheduler starts or with interrupts disabled.
+ */
+void uart_dma_flush(void)
+{
+	uint32_t state;
+	while (tx_head != tx_tail) {
+		INTERRUPT_SAVE_AND_DISABLE(state);
+		if (state == 0 && is_scheduler_running() && !is_in_handler_mode()) {
+			INTERRUPT_RESTORE(state);
+			delay_task(1);
+		} else {
+			// The DMA IRQ may never come in a handler (same or higher priority) or with PRIMASK set, poll it:
+			service_dma();
+			INTERRUPT_RESTORE(state);
+		}
+	}
+	// Last byte is still in the shift register when DMA is done:
+	while (!(REG32(USART2_BASE + USART_SR_OFFSET) & (1 << USART_SR_TC_BIT)));
+}
+
+/**
+ * @brief     Get number of bytes dropped because TX buffer was full.
+ */
+uint32_t uart_dma_get_dropped(void)
+{
+	return dropped;
+}
+
+/**
+ * @brief Write single character, used by standard library syscalls.
+ */
+int __io_putchar(int ch)
+{
+	char c = ch;
+	uart_dma_write(&c, 1);
+	return ch;
+}
+
+/* ================================== ISRS =========================== */
+/**
+ * @brief DMA transfer of one chunk is finished: release its space and start the next one.
+ */
+void DMA1_Stream6_IRQHandler(void)
+{
+	service_dma();
+}
+
+#endif /* CONFIG_UART_DMA */
@@ -0,0 +1,47 @@
+/*
+ * uart_dma.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+
+#ifndef UART_DMA_H_
+#define UART_DMA_H_
+#include "common.h"
+
+// USART2 (PA2 - TX) is connected to ST-LINK virtual COM port on STM32F412G-DISCO
+#define UART_DMA_BAUDRATE (115200U)
+#define UART_TX_BUF_SIZE CONFIG_UART_TX_BUF_SIZE		// Must be power of 2
+
+typedef enum {
+	UART_OVERFLOW_DROP,		// Drop bytes which don't fit into TX buffer
+	UART_OVERFLOW_BLOCK		// Wait till DMA frees space. Falls back to DROP in ISR or before scheduler start
+} uart_overflow_policy_t;
+
+/**
+ * @brief     Configure USART2 TX with DMA1 Stream6 and enable its interrupt.
+ * @param[in] baudrate - UART baudrate
+ * @param[in] policy - what to do when TX buffer is full
+ */
+void uart_dma_init(uint32_t baudrate, uart_overflow_policy_t policy);
+
+/**
+ * @brief     Copy data into TX ring buffer and start DMA if it is idle. Doesn't wait for transmission.
+ * @param[in] data - bytes to send
+ * @param[in] len - number of bytes
+ * @return    number of bytes queued (less than len if some were dropped)
+ */
+int uart_dma_write(const char *data, int len);
+
+/**
+ * @brief     Wait till all queued bytes are physically transmitted. Busy-waits when called from ISR, before the
+ *            scheduler starts or with interrupts disabled.
+ */
+void uart_dma_flush(void);
+
+/**
+ * @brief     Get number of bytes dropped because TX buffer was full.
+ */
+uint32_t uart_dma_get_dropped(void);
+
+#endif /* UART_DMA_H_ */
@@ -0,0 +1,128 @@
+/*
+ * active_object.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+#include "kernel_config.h"
+#if CONFIG_ACTIVE_OBJECTS
+#include "active_object.h"
+#include "scheduler.h"
+#include "atomic.h"
+
+_Static_assert(MAX_TASKS <= 32, "Subscriber masks hold one bit per task");
+
+/* ======================== GLOBAL STATE ==================================*/
+// Bit "task_id" is set if the object of that task is subscribed to the signal:
+static volatile uint32_t subscribers[AO_MAX_SIGNALS];
+static active_object_t *ao_of_task[MAX_TASKS];
+
+static const ao_event_t init_event = AO_STATIC_EVENT(AO_SIG_INIT);
+
+/* ========================================================================*/
+
+static inline void event_ref(const ao_event_t *e)
+{
+	if (e->pool != NULL)
+		atomic_add(&((ao_event_t *)e)->ref_count, 1);
+}
+
+/* Drop one reference, the last one returns the event to its pool */
+static inline void event_unref(const ao_event_t *e)
+{
+	if (e->pool != NULL && atomic_sub(&((ao_event_t *)e)->ref_count, 1) == 0)
+		mem_pool_free(e->pool, (void *)e);
+}
+
+/* Put event to the queue, reference must be taken by the caller */
+static int post_ref(active_object_t *ao, const ao_event_t *e)
+{
+	if (lf_mpmc_push(ao->queue, (void *)e) != 0) {
+		atomic_add(&ao->dropped, 1);
+		return -1;
+	}
+	task_notify(ao->task_id);
+	return 0;
+}
+
+/**
+ * @brief     Allocate event from the pool. Can be called from ISR.
+ */
+ao_event_t *ao_event_new(mem_pool_t *pool, uint16_t sig)
+{
+	ao_event_t *e = mem_pool_alloc(pool);
+	if (e != NULL) {
+		e->sig = sig;
+		e->ref_count = 0;
+		e->pool = pool;
+	}
+	return e;
+}
+
+/**
+ * @brief     Post event to the object queue. Doesn't block, can be called from ISR.
+ */
+int ao_post(active_object_t *ao, const ao_event_t *e)
+{
+	event_ref(e);
+	int ret = post_ref(ao, e);
+	if (ret != 0)
+		event_unref(e);	// frees the event if it is not referenced by any other queue
+	return ret;
+}
+
+void ao_subscribe(active_object_t *ao, uint16_t sig)
+{
+	if (sig >= AO_MAX_SIGNALS)
+		return;
+	ao_of_task[ao->task_id] = ao;
+	atomic_set_bits(&subscribers[sig], 1U << ao->task_id);
+}
+
+void ao_unsubscribe(active_object_t *ao, uint16_t sig)
+{
+	if (sig < AO_MAX_SIGNALS)
+		atomic_clear_bits(&subscribers[sig], 1U << ao->task_id);
+}
+
+/**
+ * @brief     Post event to all subscribers. Extra reference keeps the event alive till all posts are done,
+ *            even if the first subscriber already handled it.
+ */
+uint32_t ao_publish(const ao_event_t *e)
+{
+	uint32_t posted = 0;
+	uint32_t mask = (e->sig < AO_MAX_SIGNALS) ? atomic_load(&subscribers[e->sig]) : 0;
+	event_ref(e);
+	while (mask != 0) {
+		uint32_t task_id = __builtin_ctz(mask);
+		mask &= mask - 1;
+		event_ref(e);
+		if (post_ref(ao_of_task[task_id], e) == 0)
+			posted++;
+		else
+			event_unref(e);
+	}
+	event_unref(e);
+	return posted;
+}
+
+/**
+ * @brief     Active object task body: run-to-completion dispatch of every event, sleep while queue is empty.
+ */
+void ao_run(active_object_t *ao)
+{
+	void *e;
+	ao_of_task[ao->task_id] = ao;
+	ao->dispatch(ao, &init_event);
+	while (1) {
+		// Producer pushes before it notifies, so an event posted after an empty pop wakes the wait immediately:
+		while (lf_mpmc_pop(ao->queue, &e) == 0) {
+			ao->dispatch(ao, e);
+			event_unref(e);
+		}
+		task_wait_notify(WAIT_FOREVER);
+	}
+}
+
+#endif /* CONFIG_ACTIVE_OBJECTS */
@@ -0,0 +1,49 @@
+/*
+ * binlog.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+#include "kernel_config.h"
+#if CONFIG_BINLOG
+#include "binlog.h"
+#include "scheduler.h"
+#include "atomic.h"
+#if CONFIG_HR_TIMEBASE
+#include "timebase.h"
+#define BINLOG_TIMESTAMP() kernel_now_us()
+#define BINLOG_TIMESTAMP_HZ (1000000U)
+#else
+#define BINLOG_TIMESTAMP() get_tick_count()
+#define BINLOG_TIMESTAMP_HZ CONFIG_TICK_RATE_HZ
+#endif
+
+_Static_assert((BINLOG_RECORDS & (BINLOG_RECORDS - 1)) == 0, "CONFIG_BINLOG_RECORDS must be power of 2");
+
+/* ======================== GLOBAL STATE ==================================*/
+binlog_buffer_t binlog_buffer = {
+	.magic = BINLOG_MAGIC,
+	.n_records = BINLOG_RECORDS,
+	.timestamp_hz = BINLOG_TIMESTAMP_HZ,
+};
+
+/* ========================================================================*/
+
+/**
+ * @brief     Store one record. Each writer owns the slot of its sequence number, so writers don't lock each
+ *            other; the host skips a record whose seq doesn't match (being written or already overwritten).
+ */
+void binlog_write(const uint32_t *words, uint32_t n_words)
+{
+	uint32_t seq = atomic_add(&binlog_buffer.head, 1) - 1;
+	binlog_record_t *r = &binlog_buffer.records[seq & (BINLOG_RECORDS - 1)];
+	r->seq = 0;
+	r->fmt = words[0];
+	r->timestamp = BINLOG_TIMESTAMP();
+	for (uint32_t i = 1; i < n_words; i++)
+		r->args[i - 1] = words[i];
+	atomic_barrier();
+	r->seq = seq + 1;
+}
+
+#endif /* CONFIG_BINLOG */
@@ -0,0 +1,232 @@
+/*
+ * coroutine.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+#include "kernel_config.h"
+#if CONFIG_COROUTINES
+#include "coroutine.h"
+#include "hal_and_isrs.h"
+#include "atomic.h"
+
+/* ======================== GLOBAL STATE ==================================*/
+// Coroutines ready to run (FIFO). Can be appended from ISR by co_event_signal():
+static coroutine_t *ready_head = NULL;
+static coroutine_t *ready_tail = NULL;
+
+// Sleeping coroutines, slot = wake_tick % CO_WHEEL_SIZE. Used by runner task only:
+static coroutine_t *delay_wheel[CO_WHEEL_SIZE];
+static uint32_t n_delayed = 0;
+static uint32_t wheel_tick = 0;		// all slots up to this tick are processed
+
+/* ========================================================================*/
+
+static inline uint32_t tick_before(uint32_t a, uint32_t b)
+{
+	return (int32_t)(a - b) < 0;
+}
+
+/* Must be called with interrupts disabled */
+static void ready_push(coroutine_t *co)
+{
+	co->next = NULL;
+	if (ready_tail != NULL)
+		ready_tail->next = co;
+	else
+		ready_head = co;
+	ready_tail = co;
+}
+
+static coroutine_t *ready_pop(void)
+{
+	coroutine_t *co;
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	co = ready_head;
+	if (co != NULL) {
+		ready_head = co->next;
+		if (ready_head == NULL)
+			ready_tail = NULL;
+	}
+	INTERRUPT_RESTORE(state);
+	return co;
+}
+
+static void wheel_insert(coroutine_t *co)
+{
+	uint32_t state;
+	if (!tick_before(wheel_tick, co->wake_tick)) {
+		// Wake tick is already processed (f.ex. CO_DELAY(co, 0)), run on the next pass:
+		INTERRUPT_SAVE_AND_DISABLE(state);
+		ready_push(co);
+		INTERRUPT_RESTORE(state);
+		return;
+	}
+	uint32_t slot = co->wake_tick & (CO_WHEEL_SIZE - 1);
+	co->next = delay_wheel[slot];
+	delay_wheel[slot] = co;
+	n_delayed++;
+}
+
+/**
+ * @brief Move coroutines with expired delays to ready list. Processes every slot passed since the last call.
+ */
+static void wheel_advance(uint32_t now)
+{
+	uint32_t state;
+	while (tick_before(wheel_tick, now) && n_delayed > 0) {
+		wheel_tick++;
+		coroutine_t **link = &delay_wheel[wheel_tick & (CO_WHEEL_SIZE - 1)];
+		while (*link != NULL) {
+			coroutine_t *co = *link;
+			if (!tick_before(wheel_tick, co->wake_tick)) {
+				*link = co->next;
+				n_delayed--;
+				INTERRUPT_SAVE_AND_DISABLE(state);
+				ready_push(co);
+				INTERRUPT_RESTORE(state);
+			} else {
+				link = &co->next; // Expires in one of the next wheel rounds
+			}
+		}
+	}
+	wheel_tick = now;
+}
+
+/**
+ * @brief  Find how long the runner may sleep: till the nearest non-empty wheel slot.
+ * @return number of ticks from "now" or WAIT_FOREVER if there are no sleeping coroutines.
+ */
+static uint32_t ticks_to_next_wakeup(uint32_t now)
+{
+	if (n_delayed == 0)
+		return WAIT_FOREVER;
+	for (uint32_t i = 1; i <= CO_WHEEL_SIZE; i++) {
+		uint32_t tick = wheel_tick + i;
+		if (i == CO_WHEEL_SIZE || delay_wheel[tick & (CO_WHEEL_SIZE - 1)] != NULL)
+			return tick_before(now, tick) ? (tick - now) : 0;
+	}
+	return 0;
+}
+
+/**
+ * @brief     Start coroutine. Its function is first called from the runner task on the next runner pass.
+ */
+void co_start(coroutine_t *co, coroutine_fn_t fn, void *arg)
+{
+	uint32_t state;
+	co->line = 0;
+	co->state = CO_YIELDED;
+	co->wake_tick = 0;
+	co->event = NULL;
+	co->fn = fn;
+	co->arg = arg;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	ready_push(co);
+	INTERRUPT_RESTORE(state);
+	task_notify(COROUTINE_TASK_ID);
+}
+
+/**
+ * @brief     Initialize event with no pending signals.
+ */
+void co_event_init(co_event_t *ev)
+{
+	ev->count = 0;
+	ev->waiters = NULL;
+}
+
+/**
+ * @brief     Signal event: wakes all coroutines waiting for it. Can be called from ISR and preemptive tasks.
+ */
+void co_event_signal(co_event_t *ev)
+{
+	uint32_t woken = 0;
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	ev->count++;
+	while (ev->waiters != NULL) {
+		coroutine_t *co = ev->waiters;
+		ev->waiters = co->next;
+		ready_push(co);
+		woken = 1;
+	}
+	INTERRUPT_RESTORE(state);
+	if (woken)
+		task_notify(COROUTINE_TASK_ID);
+}
+
+/**
+ * @brief     Consume one pending signal, used by CO_WAIT_EVENT.
+ * @return    1 if signal was consumed, 0 if there were no signals.
+ */
+uint32_t co_event_take(co_event_t *ev)
+{
+	uint32_t count;
+	do {
+		count = atomic_load(&ev->count);
+		if (count == 0)
+			return 0;
+	} while (!atomic_cas(&ev->count, count, count - 1));
+	return 1;
+}
+
+/**
+ * @brief Park coroutine in event waiters list. If event was signaled after the coroutine checked it,
+ *        make it ready instead so the signal is not lost.
+ */
+static void event_wait(coroutine_t *co)
+{
+	co_event_t *ev = co->event;
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	if (ev->count > 0) {
+		ready_push(co);
+	} else {
+		co->next = ev->waiters;
+		ev->waiters = co;
+	}
+	INTERRUPT_RESTORE(state);
+}
+
+/**
+ * @brief     Coroutine runner task. Runs all coroutines on its own stack.
+ */
+void coroutine_runner_task(void)
+{
+	uint32_t state;
+	wheel_tick = get_tick_count();
+	while (1) {
+		wheel_advance(get_tick_count());
+
+		// Run only the coroutines which were ready at the start of the pass, so yielding ones don't starve timers:
+		coroutine_t *last = ready_tail;
+		coroutine_t *co;
+		uint32_t pass_done = (last == NULL);
+		while (!pass_done && (co = ready_pop()) != NULL) {
+			pass_done = (co == last);
+			co->state = co->fn(co);
+			switch (co->state) {
+			case CO_YIELDED:
+				INTERRUPT_SAVE_AND_DISABLE(state);
+				ready_push(co);
+				INTERRUPT_RESTORE(state);
+				break;
+			case CO_WAIT_DELAY:
+				wheel_insert(co);
+				break;
+			case CO_WAIT_EVENT:
+				event_wait(co);
+				break;
+			default:
+				break;
+			}
+		}
+
+		if (ready_head == NULL)
+			task_wait_notify(ticks_to_next_wakeup(get_tick_count()));
+	}
+}
+
+#endif /* CONFIG_COROUTINES */
@@ -0,0 +1,294 @@
+/*
+ * flash_kv.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+#include "kernel_config.h"
+#if CONFIG_FLASH_KV
+#include <string.h>
+#include "flash_kv.h"
+#include "flash_if.h"
+#include "scheduler.h"
+#include "hal_and_isrs.h"
+#include "atomic.h"
+
+#define KV_SECTOR_FIRST (10U)				// KVSTORE region of the linker script: sectors 10 and 11
+#define KV_SECTOR_SIZE FLASH_SECTOR_128K_SIZE
+#define KV_SECTOR_ADDR(i) FLASH_SECTOR_ADDR(KV_SECTOR_FIRST + (i))
+#define KV_MAGIC (0x3153564BU)				// "KVS1"
+#define KV_HEADER_B (8U)					// magic, generation
+#define KV_KEY_FREE (0xFFFFU)				// erased flash: end of the log
+#define KV_VALUE_WORDS ((KV_MAX_VALUE_B + 3U) / 4U)
+#define KV_RECORD_HDR_B (8U)
+#define KV_FLUSH_DELAY_TICKS ((CONFIG_KV_FLUSH_DELAY_MS * CONFIG_TICK_RATE_HZ + 999U) / 1000U)
+
+typedef struct kv_record_ {
+	uint16_t	key;
+	uint16_t	len;			// 0 - key deleted
+	uint32_t	crc;			// of key, len and value, detects records torn by power loss
+	uint32_t	value[KV_VALUE_WORDS];
+} kv_record_t;
+
+typedef struct kv_entry_ {
+	uint8_t		len;
+	uint8_t		present;
+	uint8_t		dirty;			// changed after it was last written to flash
+	uint8_t		value[KV_MAX_VALUE_B];
+} kv_entry_t;
+
+_Static_assert(sizeof(kv_record_t) == KV_RECORD_HDR_B + KV_VALUE_WORDS * 4U, "Record must be packed into words");
+_Static_assert(KV_HEADER_B + KV_MAX_KEYS * sizeof(kv_record_t) <= KV_SECTOR_SIZE, "All keys must fit one sector");
+
+/* ======================== GLOBAL STATE ==================================*/
+static kv_entry_t cache[KV_MAX_KEYS];
+static volatile uint32_t unwritten = 0;		// dirty entries plus entries being written
+static uint32_t active = 0;					// index of the active sector
+static uint32_t active_valid = 0;			// 0 - no sector is formatted yet
+static uint32_t generation = 0;				// of the active sector, +1 on every compaction
+static uint32_t write_pos = 0;				// offset of the next record in the active sector
+
+/* ========================================================================*/
+
+static uint32_t record_size(uint32_t len)
+{
+	return KV_RECORD_HDR_B + ((len + 3U) & ~3U);
+}
+
+static uint32_t record_crc(const kv_record_t *rec)
+{
+	const uint8_t *p = (const uint8_t *)rec->value;
+	uint32_t crc = ~((uint32_t)rec->key | ((uint32_t)rec->len << 16));
+	for (uint32_t i = 0; i < rec->len; i++) {
+		crc ^= p[i];
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ (0xEDB88320U & -(crc & 1U));
+	}
+	return ~crc;
+}
+
+/* Rebuild cache from the log of the active sector */
+static void scan_sector(void)
+{
+	uint32_t pos = KV_HEADER_B;
+	while (pos + KV_RECORD_HDR_B <= KV_SECTOR_SIZE) {
+		const kv_record_t *rec = (const kv_record_t *)(KV_SECTOR_ADDR(active) + pos);
+		if (rec->key == KV_KEY_FREE)
+			break;
+		if (rec->len > KV_MAX_VALUE_B) {
+			pos = KV_SECTOR_SIZE;	// not a record: don't append after garbage, next write compacts
+			break;
+		}
+		if (rec->key < KV_MAX_KEYS && rec->crc == record_crc(rec)) {
+			cache[rec->key].len = rec->len;
+			cache[rec->key].present = (rec->len != 0);
+			memcpy(cache[rec->key].value, rec->value, rec->len);
+		}
+		pos += record_size(rec->len);
+	}
+	write_pos = (pos < KV_SECTOR_SIZE) ? pos : KV_SECTOR_SIZE;
+}
+
+/* Copy entry to a record and mark it clean (being written). Returns 1 if the entry was dirty. */
+static uint32_t take_record(uint32_t key, kv_record_t *rec)
+{
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	kv_entry_t *e = &cache[key];
+	uint32_t was_dirty = e->dirty;
+	e->dirty = 0;
+	rec->key = key;
+	rec->len = e->present ? e->len : 0;
+	memcpy(rec->value, e->value, rec->len);
+	INTERRUPT_RESTORE(state);
+	rec->crc = record_crc(rec);
+	return was_dirty;
+}
+
+/* Record taken by take_record() didn't reach flash: make it dirty again, unless it was changed meanwhile */
+static void restore_dirty(uint32_t key)
+{
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	if (cache[key].dirty)
+		unwritten--;		// newer value is pending anyway
+	else
+		cache[key].dirty = 1;
+	INTERRUPT_RESTORE(state);
+}
+
+static void set_entry(uint32_t key, const void *data, uint32_t len)
+{
+	uint32_t state;
+	uint32_t first = 0;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	kv_entry_t *e = &cache[key];
+	// Rewriting the same value (or deleting a missing key) costs no flash write:
+	if (e->present != (len != 0) || (len != 0 && (e->len != len || memcmp(e->value, data, len) != 0))) {
+		if (len != 0)
+			memcpy(e->value, data, len);
+		e->len = len;
+		e->present = (len != 0);
+		if (!e->dirty) {
+			e->dirty = 1;
+			first = (unwritten++ == 0);
+		}
+	}
+	INTERRUPT_RESTORE(state);
+	if (first)
+		task_notify(kv_store_task_id);
+}
+
+/**
+ * @brief Write all present keys to the other (erased) sector and make it active. Old sector stays valid till the
+ *        new one gets its header, which is written last.
+ * @return 0 on success, -1 on flash error (old sector stays active).
+ */
+static int compact(void)
+{
+	uint32_t target = active_valid ? (active ^ 1U) : active;
+	uint8_t was_dirty[KV_MAX_KEYS];
+	uint32_t pos = KV_HEADER_B;
+	int ret = flash_if_erase_sector(KV_SECTOR_FIRST + target);
+	kv_record_t rec;
+
+	for (uint32_t key = 0; key < KV_MAX_KEYS; key++) {
+		was_dirty[key] = 0;
+		if (ret != 0 || (!cache[key].present && !cache[key].dirty))
+			continue;
+		was_dirty[key] = take_record(key, &rec);
+		if (rec.len == 0)
+			continue;	// deleted keys are dropped
+		ret = flash_if_program(KV_SECTOR_ADDR(target) + pos, (const uint32_t *)&rec, record_size(rec.len) / 4U);
+		pos += record_size(rec.len);
+	}
+	if (ret == 0) {
+		uint32_t header[2] = { KV_MAGIC, generation + 1U };
+		// Generation first, magic last: the sector becomes valid only when it is complete
+		ret = flash_if_program(KV_SECTOR_ADDR(target) + 4U, &header[1], 1);
+		if (ret == 0)
+			ret = flash_if_program(KV_SECTOR_ADDR(target), &header[0], 1);
+	}
+
+	for (uint32_t key = 0; key < KV_MAX_KEYS; key++) {
+		if (!was_dirty[key])
+			continue;
+		if (ret == 0)
+			atomic_sub(&unwritten, 1);
+		else
+			restore_dirty(key);
+	}
+	if (ret == 0) {
+		active = target;
+		active_valid = 1;
+		generation++;
+		write_pos = pos;
+	}
+	return ret;
+}
+
+/**
+ * @brief Append records of all dirty keys to the active sector, compact when it is full.
+ * @return 0 on success, -1 on flash error.
+ */
+static int flush(void)
+{
+	kv_record_t rec;
+	for (uint32_t key = 0; key < KV_MAX_KEYS; key++) {
+		if (!cache[key].dirty)
+			continue;
+		take_record(key, &rec);
+		uint32_t size = record_size(rec.len);
+		if (write_pos + size > KV_SECTOR_SIZE) {
+			restore_dirty(key);
+			return compact();	// writes this and all other keys
+		}
+		if (flash_if_program(KV_SECTOR_ADDR(active) + write_pos, (const uint32_t *)&rec, size / 4U) != 0) {
+			restore_dirty(key);
+			write_pos = KV_SECTOR_SIZE;		// don't append to a damaged log, rewrite everything next time
+			return -1;
+		}
+		write_pos += size;
+		atomic_sub(&unwritten, 1);
+	}
+	return 0;
+}
+
+/**
+ * @brief     Rebuild the RAM cache from flash.
+ */
+void kv_init(void)
+{
+	for (uint32_t i = 0; i < 2; i++) {
+		const uint32_t *header = (const uint32_t *)KV_SECTOR_ADDR(i);
+		if (header[0] == KV_MAGIC && (!active_valid || (int32_t)(header[1] - generation) > 0)) {
+			active = i;
+			active_valid = 1;
+			generation = header[1];
+		}
+	}
+	if (active_valid)
+		scan_sector();
+}
+
+int kv_put(uint32_t key, const void *data, uint32_t len)
+{
+	if (key >= KV_MAX_KEYS || len == 0 || len > KV_MAX_VALUE_B)
+		return -1;
+	set_entry(key, data, len);
+	return 0;
+}
+
+int kv_get(uint32_t key, void *data, uint32_t max_len)
+{
+	int ret = -1;
+	uint32_t state;
+	if (key >= KV_MAX_KEYS)
+		return -1;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	if (cache[key].present) {
+		ret = cache[key].len;
+		memcpy(data, cache[key].value, (cache[key].len < max_len) ? cache[key].len : max_len);
+	}
+	INTERRUPT_RESTORE(state);
+	return ret;
+}
+
+int kv_delete(uint32_t key)
+{
+	if (key >= KV_MAX_KEYS)
+		return -1;
+	set_entry(key, NULL, 0);
+	return 0;
+}
+
+/**
+ * @brief     Wait till all changes are written to flash.
+ */
+void kv_sync(void)
+{
+	while (atomic_load(&unwritten) != 0)
+		delay_task(KV_FLUSH_DELAY_TICKS);
+}
+
+uint32_t kv_get_erase_count(void)
+{
+	return generation;
+}
+
+/**
+ * @brief     Background task: waits for the first change, lets more changes gather, writes them all.
+ */
+void kv_store_task(void)
+{
+	if (!active_valid)
+		compact();	// first start: format
+	while (1) {
+		if (atomic_load(&unwritten) == 0)
+			task_wait_notify(WAIT_FOREVER);
+		delay_task(KV_FLUSH_DELAY_TICKS);
+		flush();
+	}
+}
+
+#endif /* CONFIG_FLASH_KV */
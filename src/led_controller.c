@@ -7,6 +7,11 @@
 
 
 #include "led_controller.h"
+#include "gpio.h"
+#if CONFIG_LED_ENGINE
+#include "hal_and_isrs.h"
+#include "stm32f412_periph.h"
+#endif
 // LED GPIO COLOR
 // 1   PE0  Green
 // 2   PE1  Orange
@@ -15,40 +20,297 @@
 
 // 0 turns LED on
 
-#define AHB1_BASE (0x40020000U)
+// Indexed by led_t. All LEDs are on port E, so any set of them is updated with one BSRR write:
+static const gpio_pin_t led_pins[] = {
+		GPIO_PIN(GPIO_PORT_E, 0),
+		GPIO_PIN(GPIO_PORT_E, 1),
+		GPIO_PIN(GPIO_PORT_E, 2),
+		GPIO_PIN(GPIO_PORT_E, 3)
+};
 
-// 1. RCC:
-/* Reset and clock control */
-#define RCC_BASE (AHB1_BASE + 0x3800)
-#define RCC ((RCC_RegDef_t *)RCC_BASE)
+#define LED_PORT_BASE GPIO_PORT_BASE(GPIO_PORT_E)
+#define LED_COUNT ARRAY_SIZE(led_pins)
 
-#define GPIOX_OFFSET (0x400U)
-#define GPIOE_BASE (AHB1_BASE + 4 * GPIOX_OFFSET)
-#define GPIOE ((GPIO_RegDef_t *)GPIOE_BASE)
-#define GPIOE_PCLK_EN() (RCC->AHB1ENR |= (1 << 4))
+#if CONFIG_LED_ENGINE
+// TIM3 counts microseconds, one counter period is one PWM frame:
+#define LED_TIM_BASE TIM3_BASE
+#define LED_TIM_HZ (1000000U)
+#define LED_FRAME_COUNTS (LED_TIM_HZ / CONFIG_LED_PWM_HZ)
+#define LED_MAX_STEPS (32U)
 
-static volatile uint32_t *pLedCtrl = (void *)(GPIOE_BASE + 0x14);
+_Static_assert(LED_FRAME_COUNTS - 1 <= 0xFFFFU, "TIM3 is 16 bit: CONFIG_LED_PWM_HZ too low");
 
-void init_leds(void)
+typedef struct led_channel_ {
+	uint32_t	pattern;		// step bits, LSB first
+	uint32_t	repeat;			// pattern cycles left, 0 - forever
+	uint16_t	step_frames;	// PWM frames per step
+	uint16_t	frames_left;	// of the current step
+	uint8_t		length;			// number of steps, 0 - static output
+	uint8_t		step;			// current step
+	uint8_t		brightness;		// duty of lit steps
+	uint8_t		lit;			// current step lights the LED
+} led_channel_t;
+
+/* ======================== GLOBAL STATE ==================================*/
+static led_channel_t channels[LED_COUNT];
+static uint16_t pwm_off_at[LED_COUNT];		// counter value to turn off the dimmed LED in the current frame
+static uint32_t pwm_pending = 0;			// LED_MASK() of dimmed LEDs still on in the current frame
+static uint32_t engine_running = 0;
+
+/* ========================================================================*/
+#endif /* CONFIG_LED_ENGINE */
+
+static uint16_t leds_to_pins(uint32_t led_mask)
+{
+	uint16_t pins = 0;
+	for (int i = 0; i < ARRAY_SIZE(led_pins); i++) {
+		if (led_mask & LED_MASK(i))
+			pins |= led_pins[i].mask;
+	}
+	return pins;
+}
+
+static void write_leds(uint32_t on_mask, uint32_t off_mask)
+{
+	// LEDs are active low, so "on" pins are reset and "off" pins are set:
+	gpio_write_mask(LED_PORT_BASE, leds_to_pins(off_mask & ~on_mask), leds_to_pins(on_mask));
+}
+
+#if CONFIG_LED_ENGINE
+static inline uint32_t channel_on(const led_channel_t *ch)
+{
+	return ch->lit && ch->brightness != 0;
+}
+
+/* Timer has work while a pattern plays or a LED is dimmed */
+static uint32_t engine_needed(void)
+{
+	for (int i = 0; i < LED_COUNT; i++) {
+		if (channels[i].length != 0 || (channels[i].brightness != 0 && channels[i].brightness != LED_BRIGHTNESS_MAX))
+			return 1;
+	}
+	return 0;
+}
+
+static void advance_step(led_channel_t *ch)
+{
+	ch->frames_left = ch->step_frames;
+	if (++ch->step == ch->length) {
+		ch->step = 0;
+		if (ch->repeat != 0 && --ch->repeat == 0) {
+			ch->length = 0;
+			ch->lit = 0;
+			return;
+		}
+	}
+	ch->lit = (ch->pattern >> ch->step) & 1U;
+}
+
+/**
+ * @brief Turn off dimmed LEDs whose edge has passed and program compare channel to the next edge.
+ *        Edges which pass while it is being programmed are handled in the loop, not lost till the next frame.
+ */
+static void pwm_edges(void)
+{
+	while (pwm_pending != 0) {
+		uint32_t next = 0xFFFFU;
+		for (uint32_t mask = pwm_pending; mask != 0; mask &= mask - 1) {
+			uint32_t led = __builtin_ctz(mask);
+			if (pwm_off_at[led] < next)
+				next = pwm_off_at[led];
+		}
+		REG32(LED_TIM_BASE + TIM_CCR1_OFFSET) = next;
+		REG32(LED_TIM_BASE + TIM_SR_OFFSET) = ~(1U << TIM_SR_CC1IF_BIT);
+		REG32(LED_TIM_BASE + TIM_DIER_OFFSET) |= (1U << TIM_DIER_CC1IE_BIT);
+		if (next > REG32(LED_TIM_BASE + TIM_CNT_OFFSET))
+			return;
+		uint32_t off = 0;
+		for (uint32_t mask = pwm_pending; mask != 0; mask &= mask - 1) {
+			uint32_t led = __builtin_ctz(mask);
+			if (pwm_off_at[led] <= next)
+				off |= LED_MASK(led);
+		}
+		pwm_pending &= ~off;
+		write_leds(0, off);
+	}
+	REG32(LED_TIM_BASE + TIM_DIER_OFFSET) &= ~(1U << TIM_DIER_CC1IE_BIT);
+}
+
+/* New PWM frame: advance patterns, light all LEDs of the frame at once, schedule turn-off edges */
+static void frame_start(void)
+{
+	uint32_t on = 0;
+	pwm_pending = 0;
+	for (int i = 0; i < LED_COUNT; i++) {
+		led_channel_t *ch = &channels[i];
+		if (ch->length != 0 && --ch->frames_left == 0)
+			advance_step(ch);
+		if (!channel_on(ch))
+			continue;
+		on |= LED_MASK(i);
+		if (ch->brightness != LED_BRIGHTNESS_MAX) {
+			pwm_off_at[i] = (uint16_t)((ch->brightness * LED_FRAME_COUNTS) / (LED_BRIGHTNESS_MAX + 1));
+			pwm_pending |= LED_MASK(i);
+		}
+	}
+	write_leds(on, LED_MASK_ALL & ~on);
+	pwm_edges();
+}
+
+/* Start or stop the timer after channel change. Must be called with interrupts disabled. */
+static void engine_update(void)
+{
+	if (engine_needed()) {
+		if (!engine_running) {
+			REG32(LED_TIM_BASE + TIM_CNT_OFFSET) = 0;
+			REG32(LED_TIM_BASE + TIM_CR1_OFFSET) |= (1U << TIM_CR1_CEN_BIT);
+			engine_running = 1;
+		}
+	} else if (engine_running) {
+		REG32(LED_TIM_BASE + TIM_CR1_OFFSET) &= ~(1U << TIM_CR1_CEN_BIT);
+		REG32(LED_TIM_BASE + TIM_DIER_OFFSET) &= ~(1U << TIM_DIER_CC1IE_BIT);
+		REG32(LED_TIM_BASE + TIM_SR_OFFSET) = 0;
+		pwm_pending = 0;
+		engine_running = 0;
+	}
+}
+
+/* Replace configuration of the LEDs and show their new state at once, PWM follows from the next frame */
+static void set_channels(uint32_t led_mask, const led_channel_t *cfg)
+{
+	uint32_t on = 0;
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	for (uint32_t mask = led_mask; mask != 0; mask &= mask - 1) {
+		uint32_t led = __builtin_ctz(mask);
+		channels[led] = *cfg;
+		if (channel_on(cfg))
+			on |= LED_MASK(led);
+	}
+	pwm_pending &= ~led_mask;
+	write_leds(on, led_mask & ~on);
+	engine_update();
+	INTERRUPT_RESTORE(state);
+}
+
+static uint32_t ms_to_frames(uint32_t ms)
+{
+	uint32_t frames = (uint32_t)(((uint64_t)ms * CONFIG_LED_PWM_HZ + 500U) / 1000U);
+	return (frames == 0) ? 1 : (frames > 0xFFFFU) ? 0xFFFFU : frames;
+}
+
+static uint32_t gcd(uint32_t a, uint32_t b)
+{
+	while (b != 0) {
+		uint32_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/**
+ * @brief     Start TIM3 and its interrupt. Called by init_leds().
+ */
+void led_engine_init(void)
+{
+	REG32(RCC_APB1ENR) |= (1 << RCC_APB1ENR_TIM3EN_BIT);
+	REG32(LED_TIM_BASE + TIM_CR1_OFFSET) &= ~(1U << TIM_CR1_CEN_BIT);
+	REG32(LED_TIM_BASE + TIM_PSC_OFFSET) = (APB1_TIMER_CLOCK_RATE / LED_TIM_HZ) - 1;
+	REG32(LED_TIM_BASE + TIM_ARR_OFFSET) = LED_FRAME_COUNTS - 1;
+	REG32(LED_TIM_BASE + TIM_EGR_OFFSET) = (1U << TIM_EGR_UG_BIT);	// load prescaler
+	REG32(LED_TIM_BASE + TIM_SR_OFFSET) = 0;
+	REG32(LED_TIM_BASE + TIM_DIER_OFFSET) = (1U << TIM_DIER_UIE_BIT);
+	nvic_enable_irq(IRQ_NUM_TIM3);
+}
+
+void led_set_brightness(led_t led, uint8_t brightness)
+{
+	led_channel_t cfg = { .brightness = brightness, .lit = 1 };
+	set_channels(LED_MASK(led), &cfg);
+}
+
+static void start_pattern(led_t led, uint32_t pattern, uint32_t length, uint32_t step_frames, uint32_t repeat)
 {
-	// Enable clock to GPIOE:
-	volatile uint32_t *pRCC_AHB1_EN = (void *)(RCC_BASE + 0x30);
-	*pRCC_AHB1_EN |= (1 << 4);
+	// Keep brightness set by led_set_brightness(), a LED which was off blinks at full brightness:
+	uint8_t brightness = channels[led].brightness ? channels[led].brightness : LED_BRIGHTNESS_MAX;
+	led_channel_t cfg = {
+		.pattern = pattern, .repeat = repeat, .step_frames = step_frames, .frames_left = step_frames,
+		.length = length, .step = 0, .brightness = brightness, .lit = pattern & 1U
+	};
+	set_channels(LED_MASK(led), &cfg);
+}
+
+void led_pattern(led_t led, uint32_t pattern, uint32_t length, uint32_t step_ms, uint32_t repeat)
+{
+	if (length != 0 && length <= LED_MAX_STEPS)
+		start_pattern(led, pattern, length, ms_to_frames(step_ms), repeat);
+}
 
-	// Enable 4 ports of GPIOE: PE0 - PE3 to output:
-	volatile uint32_t *pGPIOE_MODE = (void *)(GPIOE_BASE);
-	*pGPIOE_MODE &= ~(0xFF); // clear 8 LBSs
-	*pGPIOE_MODE |= 0x55; // put output_mode = "01" to last 8 bits, resulting to 01010101
+void led_blink(led_t led, uint32_t on_ms, uint32_t off_ms)
+{
+	uint32_t on = ms_to_frames(on_ms);
+	uint32_t off = ms_to_frames(off_ms);
+	// Common step of both times, or a coarser one if the cycle doesn't fit into the pattern bits:
+	uint32_t step = gcd(on, off);
+	if ((on + off) / step > LED_MAX_STEPS)
+		step = (on + off + LED_MAX_STEPS - 1) / LED_MAX_STEPS;
+	uint32_t on_steps = (on + step / 2) / step;
+	on_steps = (on_steps == 0) ? 1 : (on_steps > LED_MAX_STEPS - 1) ? LED_MAX_STEPS - 1 : on_steps;
+	uint32_t off_steps = (off + step / 2) / step;
+	off_steps = (off_steps == 0) ? 1 : (off_steps > LED_MAX_STEPS - on_steps) ? LED_MAX_STEPS - on_steps : off_steps;
+	start_pattern(led, (1U << on_steps) - 1, on_steps + off_steps, step, 0);
+}
+
+/**
+ * @brief TIM3: compare - turn-off edge of dimmed LEDs, update - start of the next PWM frame.
+ */
+void TIM3_IRQHandler(void)
+{
+	uint32_t sr = REG32(LED_TIM_BASE + TIM_SR_OFFSET);
+	if (sr & (1U << TIM_SR_CC1IF_BIT)) {
+		REG32(LED_TIM_BASE + TIM_SR_OFFSET) = ~(1U << TIM_SR_CC1IF_BIT);
+		pwm_edges();
+	}
+	if (sr & (1U << TIM_SR_UIF_BIT)) {
+		REG32(LED_TIM_BASE + TIM_SR_OFFSET) = ~(1U << TIM_SR_UIF_BIT);
+		frame_start();
+		engine_update();	// stop once all patterns finished and nothing is dimmed
+	}
+}
+#endif /* CONFIG_LED_ENGINE */
+
+void init_leds(void)
+{
+	for (int i = 0; i < LED_COUNT; i++)
+		gpio_init_output(&led_pins[i], GPIO_PUSH_PULL);
 
 	// Make all leds off first:
-	*pLedCtrl |= 0xF;
+	write_leds(0, LED_MASK_ALL);
+#if CONFIG_LED_ENGINE
+	led_engine_init();
+#endif
 }
 
 void turn_led(led_t led, led_state_t on_off) {
-	if (on_off == LED_OFF)
-		*pLedCtrl |= (1 << led);
-	else
-		*pLedCtrl &= ~(1 << led);
+#if CONFIG_LED_ENGINE
+	led_set_brightness(led, (on_off == LED_ON) ? LED_BRIGHTNESS_MAX : 0);
+#else
+	// LEDs are active low:
+	gpio_write(&led_pins[led], on_off == LED_OFF);
+#endif
 }
 
-
+void set_leds(uint32_t on_mask, uint32_t off_mask) {
+#if CONFIG_LED_ENGINE
+	led_channel_t on_cfg = { .brightness = LED_BRIGHTNESS_MAX, .lit = 1 };
+	led_channel_t off_cfg = { .brightness = 0, .lit = 1 };
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	set_channels(off_mask & ~on_mask, &off_cfg);
+	set_channels(on_mask, &on_cfg);
+	INTERRUPT_RESTORE(state);
+#else
+	write_leds(on_mask, off_mask);
+#endif
+}
@@ -0,0 +1,93 @@
+/*
+ * lf_queue.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+#include "lf_queue.h"
+#include "atomic.h"
+
+/**
+ * @brief     Put item to the SPSC queue: write the slot, then publish it by moving head.
+ */
+int lf_spsc_push(lf_spsc_t *q, void *item)
+{
+	uint32_t head = q->head;
+	if (head - atomic_load(&q->tail) > q->mask)
+		return -1;
+	q->buffer[head & q->mask] = item;
+	atomic_store(&q->head, head + 1);
+	return 0;
+}
+
+/**
+ * @brief     Take item from the SPSC queue: read the slot, then release it by moving tail.
+ */
+int lf_spsc_pop(lf_spsc_t *q, void **item)
+{
+	uint32_t tail = q->tail;
+	if (atomic_load(&q->head) == tail)
+		return -1;
+	*item = q->buffer[tail & q->mask];
+	atomic_store(&q->tail, tail + 1);
+	return 0;
+}
+
+uint32_t lf_spsc_count(lf_spsc_t *q)
+{
+	return q->head - q->tail;
+}
+
+/*
+ * Cell at position "pos" (index = pos & mask) is:
+ *  - free for the producer of "pos" when seq == pos
+ *  - holds data for the consumer of "pos" when seq == pos + 1
+ * Stored value is seq - index, so all cells start free with zero.
+ */
+static inline uint32_t cell_seq(lf_mpmc_t *q, lf_mpmc_cell_t *cell, uint32_t pos)
+{
+	return atomic_load(&cell->seq) + (pos & q->mask);
+}
+
+static inline void cell_set_seq(lf_mpmc_t *q, lf_mpmc_cell_t *cell, uint32_t pos, uint32_t seq)
+{
+	atomic_store(&cell->seq, seq - (pos & q->mask));
+}
+
+int lf_mpmc_push(lf_mpmc_t *q, void *item)
+{
+	uint32_t pos = atomic_load(&q->enqueue_pos);
+	while (1) {
+		lf_mpmc_cell_t *cell = &q->cells[pos & q->mask];
+		int32_t diff = (int32_t)(cell_seq(q, cell, pos) - pos);
+		if (diff == 0) {
+			if (atomic_cas(&q->enqueue_pos, pos, pos + 1)) {
+				cell->data = item;
+				cell_set_seq(q, cell, pos, pos + 1);
+				return 0;
+			}
+		} else if (diff < 0) {
+			return -1;	// cell still holds data from the previous lap
+		}
+		pos = atomic_load(&q->enqueue_pos);	// other producer took this position
+	}
+}
+
+int lf_mpmc_pop(lf_mpmc_t *q, void **item)
+{
+	uint32_t pos = atomic_load(&q->dequeue_pos);
+	while (1) {
+		lf_mpmc_cell_t *cell = &q->cells[pos & q->mask];
+		int32_t diff = (int32_t)(cell_seq(q, cell, pos) - (pos + 1));
+		if (diff == 0) {
+			if (atomic_cas(&q->dequeue_pos, pos, pos + 1)) {
+				*item = cell->data;
+				cell_set_seq(q, cell, pos, pos + q->mask + 1);
+				return 0;
+			}
+		} else if (diff < 0) {
+			return -1;	// not published yet
+		}
+		pos = atomic_load(&q->dequeue_pos);	// other consumer took this position
+	}
+}
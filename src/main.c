@@ -22,6 +22,22 @@
 #ifdef OPENOCD_SEMIHOSTING_ENABLED
 extern void initialise_monitor_handles(void);
 #endif /* OPENOCD_SEMIHOSTING_ENABLED */
+#if CONFIG_DVFS
+#include "dvfs.h"
+#endif /* CONFIG_DVFS */
+#if CONFIG_UART_DMA
+#include "uart_dma.h"
+#endif /* CONFIG_UART_DMA */
+#if CONFIG_HR_TIMEBASE
+#include "timebase.h"
+#endif /* CONFIG_HR_TIMEBASE */
+#if CONFIG_DMA_COPY
+#include "dma_copy.h"
+#endif /* CONFIG_DMA_COPY */
+#if CONFIG_FLASH_KV
+#include "flash_if.h"
+#include "flash_kv.h"
+#endif /* CONFIG_FLASH_KV */
 
 int main(void)
 {
@@ -29,9 +45,37 @@ int main(void)
 	initialise_monitor_handles();
 	printf("Semihosting works\n");
 #endif /* OPENOCD_SEMIHOSTING_ENABLED */
+#if CONFIG_DVFS
+	dvfs_init();	// sets APB1 prescaler, so before peripherals
+#endif /* CONFIG_DVFS */
+#if CONFIG_UART_DMA
+	uart_dma_init(UART_DMA_BAUDRATE, UART_OVERFLOW_DROP);
+	printf("UART works\n");
+#endif /* CONFIG_UART_DMA */
+#if CONFIG_HR_TIMEBASE
+	timebase_init();
+#endif /* CONFIG_HR_TIMEBASE */
+#if CONFIG_DMA_COPY
+	dma_copy_init();
+#if CONFIG_DMA_COPY_BENCH
+	dma_copy_benchmark();
+#endif
+#endif /* CONFIG_DMA_COPY */
+#if CONFIG_FLASH_KV
+	flash_if_init();
+	kv_init();
+#endif /* CONFIG_FLASH_KV */
 
 	init_leds();
-	init_and_run_scheduler();
+#if CONFIG_LED_ENGINE
+	start_led_blinkers();
+#endif /* CONFIG_LED_ENGINE */
+	if (init_and_run_scheduler() != 0) {
+		// Admission control rejected the task list (reasons are logged), nothing runs:
+		printf("Task set rejected by admission control\n");
+		set_leds(LED_MASK(LED_RED), LED_MASK_ALL);
+		while(1);
+	}
 
     /* Should never come here. In case of all tasks are finished/blocked, "task_idle" will run.  */
 }
@@ -0,0 +1,90 @@
+/*
+ * mem_pool.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+#include "kernel_config.h"
+#if CONFIG_MEM_POOLS
+#include "mem_pool.h"
+#include "hal_and_isrs.h"
+
+/**
+ * @brief     Initialize pool at run time over user provided buffer (alternative to MEM_POOL_DEFINE).
+ */
+void mem_pool_init(mem_pool_t *pool, void *buffer, uint32_t size, uint32_t n_blocks)
+{
+	pool->buffer = buffer;
+	pool->block_size = MEM_POOL_BLOCK_SIZE(size);
+	pool->n_blocks = n_blocks;
+	pool->free_list = NULL;
+	pool->n_carved = 0;
+	pool->n_used = 0;
+	pool->max_used = 0;
+	pool->alloc_fails = 0;
+}
+
+/**
+ * @brief     Allocate one block. O(1), can be called from ISR.
+ * @return    pointer to block or NULL if pool is empty.
+ */
+void *mem_pool_alloc(mem_pool_t *pool)
+{
+	void *block = NULL;
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	if (pool->free_list != NULL) {
+		block = pool->free_list;
+		pool->free_list = *(void **)block;
+	} else if (pool->n_carved < pool->n_blocks) {
+		block = pool->buffer + pool->n_carved * pool->block_size;
+		pool->n_carved++;
+	}
+
+	if (block != NULL) {
+		pool->n_used++;
+		if (pool->n_used > pool->max_used)
+			pool->max_used = pool->n_used;
+	} else {
+		pool->alloc_fails++;
+	}
+	INTERRUPT_RESTORE(state);
+	return block;
+}
+
+/**
+ * @brief     Return block to the pool. O(1), can be called from ISR.
+ * @return    0 on success, -1 if block doesn't belong to the pool.
+ */
+int mem_pool_free(mem_pool_t *pool, void *block)
+{
+	uint32_t offset = (uint8_t *)block - pool->buffer;
+	uint32_t state;
+	if ((uint8_t *)block < pool->buffer || offset >= pool->n_carved * pool->block_size ||
+			(offset % pool->block_size) != 0)
+		return -1;
+
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	*(void **)block = pool->free_list;
+	pool->free_list = block;
+	pool->n_used--;
+	INTERRUPT_RESTORE(state);
+	return 0;
+}
+
+/**
+ * @brief     Get usage statistics of the pool.
+ */
+void mem_pool_get_stats(mem_pool_t *pool, mem_pool_stats_t *stats)
+{
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	stats->block_size = pool->block_size;
+	stats->n_blocks = pool->n_blocks;
+	stats->n_used = pool->n_used;
+	stats->max_used = pool->max_used;
+	stats->alloc_fails = pool->alloc_fails;
+	INTERRUPT_RESTORE(state);
+}
+
+#endif /* CONFIG_MEM_POOLS */
@@ -0,0 +1,83 @@
+/*
+ * profiler.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+#include "kernel_config.h"
+#if CONFIG_PROFILER
+#include <string.h>
+#include "profiler.h"
+#include "scheduler.h"
+#include "hal_and_isrs.h"
+
+#define FRAME_PC_INDEX (6)			// R0, R1, R2, R3, R12, LR, PC, xPSR
+#define EXC_RETURN_PSP_BIT (2)
+#define PROBE_LIMIT (8U)			// max slots checked per sample
+
+_Static_assert((PROFILER_SLOTS & (PROFILER_SLOTS - 1)) == 0, "CONFIG_PROFILER_SLOTS must be power of 2");
+_Static_assert(MAX_TASKS < PROFILER_TASK_ISR, "Task ids must not clash with PROFILER_TASK_ISR");
+
+#define TASK_HANDLER_DECLARE(entry, stack_size, ...) void entry(void);
+KERNEL_TASK_LIST(TASK_HANDLER_DECLARE)
+
+#define TASK_ENTRY_ADDR(entry, stack_size, ...) entry,
+
+/* ======================== GLOBAL STATE ==================================*/
+profiler_buffer_t profiler_buffer = {
+	.magic = PROFILER_MAGIC,
+	.n_tasks = MAX_TASKS,
+	.n_slots = PROFILER_SLOTS,
+	.enabled = CONFIG_PROFILER_AUTOSTART,
+	.task_entry = { KERNEL_TASK_LIST(TASK_ENTRY_ADDR) },
+};
+
+/* ========================================================================*/
+
+void profiler_start(void)
+{
+	profiler_buffer.enabled = 1;
+}
+
+void profiler_stop(void)
+{
+	profiler_buffer.enabled = 0;
+}
+
+void profiler_reset(void)
+{
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	memset(profiler_buffer.slots, 0, sizeof(profiler_buffer.slots));
+	profiler_buffer.samples = 0;
+	profiler_buffer.dropped = 0;
+	INTERRUPT_RESTORE(state);
+}
+
+/**
+ * @brief     Add one sample to the open addressing hash table of (task, PC).
+ */
+void profiler_sample(const uint32_t *frame, uint32_t exc_return)
+{
+	if (!profiler_buffer.enabled)
+		return;
+	uint32_t pc = frame[FRAME_PC_INDEX];
+	uint32_t task_plus_1 = ((exc_return & (1U << EXC_RETURN_PSP_BIT)) ? get_current_task_id() : PROFILER_TASK_ISR) + 1;
+	uint32_t index = ((pc >> 1) * 2654435761U + task_plus_1) & (PROFILER_SLOTS - 1);
+
+	profiler_buffer.samples++;
+	for (uint32_t probe = 0; probe < PROBE_LIMIT; probe++) {
+		profiler_slot_t *slot = &profiler_buffer.slots[(index + probe) & (PROFILER_SLOTS - 1)];
+		if (slot->task_plus_1 == PROFILER_TASK_FREE) {
+			slot->pc = pc;
+			slot->task_plus_1 = task_plus_1;
+		}
+		if (slot->pc == pc && slot->task_plus_1 == task_plus_1) {
+			slot->count++;
+			return;
+		}
+	}
+	profiler_buffer.dropped++;
+}
+
+#endif /* CONFIG_PROFILER */
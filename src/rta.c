@@ -0,0 +1,72 @@
+/*
+ * rta.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ *
+ * No kernel dependencies: also built into the host simulator. Unused in the image without
+ * CONFIG_ADMISSION_CONTROL, --gc-sections drops it.
+ */
+#include "rta.h"
+
+int32_t rta_assign_rate_monotonic(rta_task_t *set, uint32_t n, uint8_t top_priority)
+{
+	for (uint32_t i = 0; i < n; i++) {
+		if (set[i].fixed)
+			continue;
+		// Priority level = number of distinct shorter periods (each counted at its first task):
+		uint32_t level = 0;
+		for (uint32_t j = 0; j < n; j++) {
+			if (set[j].fixed || set[j].period_us >= set[i].period_us)
+				continue;
+			uint32_t first = 1;
+			for (uint32_t k = 0; k < j && first; k++)
+				first = (set[k].fixed || set[k].period_us != set[j].period_us);
+			level += first;
+		}
+		if (level > top_priority)
+			return -1;
+		set[i].priority = top_priority - level;
+		set[i].threshold = set[i].priority;
+	}
+	return 0;
+}
+
+uint32_t rta_response_times(rta_task_t *set, uint32_t n, uint32_t overhead_us)
+{
+	uint32_t misses = 0;
+	for (uint32_t i = 0; i < n; i++) {
+		set[i].response_us = 0;
+		if (set[i].fixed)
+			continue;
+		uint64_t blocking = 0;
+		for (uint32_t j = 0; j < n; j++) {
+			if (set[j].priority < set[i].priority && set[j].threshold >= set[i].priority &&
+					(uint64_t)set[j].wcet_us + 2 * overhead_us > blocking)
+				blocking = (uint64_t)set[j].wcet_us + 2 * overhead_us;
+		}
+		uint64_t c = blocking + set[i].wcet_us + 2 * overhead_us;
+		uint64_t r = c, r_prev = 0;
+		while (r != r_prev && r <= set[i].deadline_us) {
+			r_prev = r;
+			r = c;
+			for (uint32_t j = 0; j < n; j++) {
+				if (j == i || set[j].priority < set[i].priority)
+					continue;
+				r += ((r_prev + set[j].jitter_us + set[j].period_us - 1) / set[j].period_us) *
+						((uint64_t)set[j].wcet_us + 2 * overhead_us);
+			}
+		}
+		set[i].response_us = (r <= set[i].deadline_us) ? (uint32_t)r : 0;
+		misses += (set[i].response_us == 0);
+	}
+	return misses;
+}
+
+uint32_t rta_utilization_permille(const rta_task_t *set, uint32_t n)
+{
+	uint32_t u = 0;
+	for (uint32_t i = 0; i < n; i++)
+		u += (uint32_t)(((uint64_t)set[i].wcet_us * 1000U) / set[i].period_us);
+	return u;
+}
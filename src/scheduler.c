@@ -7,6 +7,20 @@
 #include "scheduler.h"
 #include "hal_and_isrs.h"
 #include "task.h"
+#include "atomic.h"
+#include "binlog.h"
+#if (CONFIG_STATS && CONFIG_HR_TIMEBASE) || CONFIG_TASK_BUDGETS
+#include "timebase.h"
+#endif
+#if CONFIG_SW_TIMERS
+#include "sw_timer.h"
+#endif
+#if CONFIG_COROUTINES
+#include "coroutine.h"
+#endif
+#if CONFIG_ADMISSION_CONTROL
+#include "rta.h"
+#endif
 
 /* ======================== DEPENDS ON NEXT HAL FUNCTIONS: ==================================*/
 extern void enable_all_configurable_exceptions(void);
@@ -15,20 +29,78 @@ extern void change_sp_to_psp(void);
 extern void initial_systick_config(void);
 extern void init_scheduler_stack(void *start_of_stack);
 extern void init_task_stack(TCB_t *task_descriptor);
+extern uint32_t is_in_handler_mode(void);
 
 /* ======================== GLOBAL STATE ==================================*/
-static uint32_t global_tick_count = 0;
+static volatile uint32_t global_tick_count = 0;	// written by SysTick only, read without masking
+static uint32_t scheduler_running = 0;
 
-static TCB_t tasks[MAX_TASKS] = {
-		{(uint32_t *)TASK_IDLE_STACK_START, TASK_READY, 0, task_idle},
-		{(uint32_t *)TASK_1_STACK_START, TASK_READY, 0, task_1_handler},
-		{(uint32_t *)TASK_2_STACK_START, TASK_READY, 0, task_2_handler},
-		{(uint32_t *)TASK_3_STACK_START, TASK_READY, 0, task_3_handler},
-		{(uint32_t *)TASK_4_STACK_START, TASK_READY, 0, task_4_handler}
+// Handlers of all tasks, user ones may be generated by macros (e.g. ACTIVE_OBJECT_DEFINE) without a header:
+#define TASK_HANDLER_DECLARE(entry, stack_size, ...) void entry(void);
+KERNEL_TASK_LIST(TASK_HANDLER_DECLARE)
+
+// Stacks of all tasks from KERNEL_TASK_LIST: <entry>_stack
+#define TASK_STACK_DEFINE(entry, stack_size, ...) \
+	static uint32_t entry##_stack[TASK_STACK_SIZE(entry, stack_size) / sizeof(uint32_t)] __attribute__((aligned(8)));
+KERNEL_TASK_LIST(TASK_STACK_DEFINE)
+
+#if CONFIG_STACK_CHECK
+#define TCB_STACK_LIMIT_INIT(entry) .stack_limit = entry##_stack,
+#else
+#define TCB_STACK_LIMIT_INIT(entry)
+#endif
 
+// Stack grows down, so initial stack pointer is the end of the stack array:
+#define TASK_TCB_INIT(entry, stack_size, ...) \
+	[entry##_id] = { \
+		.stack_start = &entry##_stack[TASK_STACK_SIZE(entry, stack_size) / sizeof(uint32_t)], \
+		.current_state = TASK_READY, \
+		.handler = entry, \
+		TCB_STACK_LIMIT_INIT(entry) \
+		__VA_ARGS__ \
+	},
+
+static TCB_t tasks[MAX_TASKS] = {
+		KERNEL_TASK_LIST(TASK_TCB_INIT)
 };
 
-uint32_t current_task = 1;
+#define FIRST_TASK_ID ((MAX_TASKS > 1) ? 1 : IDLE_TASK_ID)
+
+uint32_t current_task = FIRST_TASK_ID;
+
+#if CONFIG_SCHED_POLICY == SCHED_POLICY_CYCLIC
+#include "cyclic_table.h"	// generated from the task set: make CYCLIC_TASKSET=<file>
+
+#define CYCLIC_FRAME_TICKS (CYCLIC_FRAME_US * CONFIG_TICK_RATE_HZ / 1000000U)
+_Static_assert((CYCLIC_FRAME_US * CONFIG_TICK_RATE_HZ) % 1000000U == 0 && CYCLIC_FRAME_TICKS > 0,
+		"Minor frame must be a whole number of scheduler ticks");
+
+static uint32_t frame_index = 0;
+static uint32_t frame_tick = 0;
+static uint32_t frame_overruns[CYCLIC_FRAMES];
+#endif
+
+#if CONFIG_STATS
+static uint32_t context_switch_count = 0;
+static uint32_t preemptions_avoided = 0;
+static uint32_t merged_wakeups = 0;
+#if CONFIG_HR_TIMEBASE
+static uint32_t last_switch_us = 0;
+#endif
+#endif
+
+#if CONFIG_HW_COUNTERS
+static uint32_t last_harvest;		// CYCCNT when it was last added to a task
+#endif
+
+#if CONFIG_TASK_BUDGETS
+static uint32_t last_charge_us = 0;		// when the running task was last charged for its CPU time
+#endif
+
+#if CONFIG_ADMISSION_CONTROL && CONFIG_STATS && CONFIG_HR_TIMEBASE
+static uint32_t report_us = 0;			// time of the previous task_utilization_report()
+static uint32_t report_run_us[MAX_TASKS];
+#endif
 
 /* ========================================================================*/
 
@@ -36,46 +108,498 @@ static void init_tasks(uint32_t n_tasks)
 {
 	for (int i = 0; i < n_tasks; i++) {
 		tasks[i].current_state = TASK_READY;
+#if CONFIG_STACK_CHECK
+		*tasks[i].stack_limit = STACK_CANARY;
+#endif
 		init_task_stack(&tasks[i]);
+#if CONFIG_TASK_BUDGETS
+		tasks[i].replenish_tick = tasks[i].budget_period;
+#endif
+	}
+}
+
+#if CONFIG_STACK_CHECK
+/**
+ * @brief Check that task didn't grow its stack below the limit. Called for the task which is switched out.
+ */
+static void check_task_stack(uint32_t task_id)
+{
+	if (tasks[task_id].stack_start <= tasks[task_id].stack_limit || *tasks[task_id].stack_limit != STACK_CANARY) {
+		LOG("Stack overflow: task %lu", (unsigned long)task_id);
+		while(1);
+	}
+}
+#endif /* CONFIG_STACK_CHECK */
+
+#if CONFIG_HW_COUNTERS
+/**
+ * @brief Add DWT cycles since the last harvest to the task. Called on every switch and tick, far more often than
+ *        the 32-bit CYCCNT wraps.
+ */
+static void harvest_task_hw_counters(uint32_t task_id)
+{
+	uint32_t state;
+	// SysTick may harvest in the middle of the PendSV one:
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	uint32_t now = dwt_get_cycles();
+	tasks[task_id].hw_counters.cycles += now - last_harvest;
+	last_harvest = now;
+	INTERRUPT_RESTORE(state);
+}
+#endif /* CONFIG_HW_COUNTERS */
+
+#if CONFIG_TASK_BUDGETS
+/**
+ * @brief Charge the running task for the CPU time since it was last charged. Called on every switch and tick.
+ */
+static void charge_running_task(void)
+{
+	uint32_t state;
+	// SysTick may charge in the middle of the PendSV one:
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	uint32_t now_us = kernel_now_us();
+	tasks[current_task].budget_used_us += now_us - last_charge_us;
+	last_charge_us = now_us;
+	INTERRUPT_RESTORE(state);
+}
+
+/* Task used up its budget and wasn't throttled or demoted for it yet */
+static inline uint32_t is_over_budget(uint32_t task_id)
+{
+	return tasks[task_id].budget_us != 0 && tasks[task_id].budget_used_us >= tasks[task_id].budget_us &&
+			!tasks[task_id].budget_demoted;
+}
+
+/**
+ * @brief Move a TASK_READY task which used up its budget to TASK_THROTTLED till the next replenishment.
+ *        An aperiodic server (budget_fallback) stays ready at its fallback priority instead.
+ * @return 1 if the task was throttled or demoted.
+ */
+static uint32_t throttle_if_exhausted(uint32_t task_id)
+{
+	TCB_t *task = &tasks[task_id];
+	if (!is_over_budget(task_id))
+		return 0;
+#if CONFIG_SCHED_POLICY == SCHED_POLICY_PRIORITY
+	if (task->budget_fallback) {
+		task->budget_priority = task->priority;
+		task->priority = task->fallback_priority;
+		task->budget_demoted = 1;
+		task->threshold_active = 0;
+		task->budget_overruns++;
+		return 1;
+	}
+#endif
+	if (!atomic_cas(&task->current_state, TASK_READY, TASK_THROTTLED))
+		return 0;
+	task->threshold_active = 0;
+	task->budget_overruns++;
+	return 1;
+}
+
+/* Give a demoted aperiodic server its priority back */
+static uint32_t restore_budget_priority(TCB_t *task)
+{
+	if (!task->budget_demoted)
+		return 0;
+	task->priority = task->budget_priority;
+	task->budget_demoted = 0;
+	return 1;
+}
+#endif /* CONFIG_TASK_BUDGETS */
+
+#if CONFIG_ADMISSION_CONTROL
+#define ADMISSION_TICK_US (1000000U / CONFIG_TICK_RATE_HZ)
+
+/**
+ * @brief Admission test of all tasks which declare a period: rate-monotonic priorities, then response time
+ *        analysis (rta.c). Tasks without period which can run at or above the lowest rate-monotonic priority
+ *        interfere at their own priority with their budget: budget_us plus one tick (budgets are enforced on
+ *        ticks) every budget_period, released with jitter of the rest of the period, as an aperiodic server
+ *        can use its budget at the end of one period and at the start of the next. Such a task without budget
+ *        can't be bounded and the set is rejected. Priorities are changed only if every periodic task meets its
+ *        deadline, otherwise the tasks which can miss it are logged.
+ * @return 0 if the task set is schedulable, -1 if it is rejected.
+ */
+static int32_t admit_task_set(void)
+{
+	rta_task_t set[MAX_TASKS];
+	uint8_t ids[MAX_TASKS];
+	uint32_t n = 0;
+	for (uint32_t i = 1; i < MAX_TASKS; i++) {
+		if (tasks[i].period_us == 0)
+			continue;
+		ids[n] = i;
+		set[n] = (rta_task_t){ .period_us = tasks[i].period_us, .wcet_us = tasks[i].wcet_us,
+				.deadline_us = (tasks[i].deadline_us != 0) ? tasks[i].deadline_us : tasks[i].period_us };
+		n++;
+	}
+	if (n == 0)
+		return 0;
+	if (rta_assign_rate_monotonic(set, n, CONFIG_RM_TOP_PRIORITY) != 0) {
+		LOG("Admission: more distinct periods than priorities up to %lu", (unsigned long)CONFIG_RM_TOP_PRIORITY);
+		return -1;
+	}
+	uint32_t n_periodic = n;
+	uint32_t lowest = CONFIG_RM_TOP_PRIORITY;
+	for (uint32_t k = 0; k < n_periodic; k++) {
+		if (set[k].priority < lowest)
+			lowest = set[k].priority;
+	}
+	for (uint32_t i = 1; i < MAX_TASKS; i++) {
+		const TCB_t *task = &tasks[i];
+		if (task->period_us != 0)
+			continue;
+		// A demoted aperiodic server gets its priority back on replenishment:
+		uint32_t priority = task->budget_demoted ? task->budget_priority : task->priority;
+		uint32_t budgeted = (task->budget_us != 0 && task->budget_period != 0);
+		// Without budget (or out of it for a server) the task runs as long as it wants:
+		if (!budgeted || task->budget_fallback) {
+			uint32_t level = budgeted ? task->fallback_priority : priority;
+			if (task->preempt_threshold > level)
+				level = task->preempt_threshold;
+			if (level >= lowest) {
+				LOG("Admission: task %lu has no period or budget bound at priority %lu, periodic tasks from %lu",
+						(unsigned long)i, (unsigned long)level, (unsigned long)lowest);
+				return -1;
+			}
+		}
+		uint32_t threshold = (task->preempt_threshold > priority) ? task->preempt_threshold : priority;
+		if (!budgeted || threshold < lowest)
+			continue;
+		uint32_t period_us = task->budget_period * ADMISSION_TICK_US;
+		uint32_t budget_us = (task->budget_us < period_us) ? task->budget_us : period_us;
+		uint32_t load_us = (budget_us + ADMISSION_TICK_US < period_us) ? budget_us + ADMISSION_TICK_US : period_us;
+		set[n] = (rta_task_t){ .period_us = period_us, .wcet_us = load_us, .deadline_us = period_us,
+				.jitter_us = period_us - budget_us, .priority = priority, .threshold = threshold, .fixed = 1 };
+		n++;
+	}
+	if (rta_response_times(set, n, CONFIG_RTA_SWITCH_OVERHEAD_US) != 0) {
+		LOG("Admission: task set rejected, utilization %lu/1000", (unsigned long)rta_utilization_permille(set, n));
+		for (uint32_t k = 0; k < n_periodic; k++) {
+			if (set[k].response_us == 0)
+				LOG("Admission: task %lu (period %lu us, wcet %lu us, priority %lu) can miss its %lu us deadline",
+						(unsigned long)ids[k], (unsigned long)set[k].period_us, (unsigned long)set[k].wcet_us,
+						(unsigned long)set[k].priority, (unsigned long)set[k].deadline_us);
+		}
+		return -1;
+	}
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	for (uint32_t k = 0; k < n_periodic; k++) {
+		tasks[ids[k]].priority = set[k].priority;
+		tasks[ids[k]].preempt_threshold = 0;
+		tasks[ids[k]].response_us = set[k].response_us;
+	}
+	INTERRUPT_RESTORE(state);
+	return 0;
+}
+#endif /* CONFIG_ADMISSION_CONTROL */
+
+#if CONFIG_TRACE
+/**
+ * @brief Trace hook called on every context switch. Weak, override it to record switches.
+ */
+__attribute__((weak)) void trace_task_switch(uint32_t from_task, uint32_t to_task)
+{
+	(void)from_task;
+	(void)to_task;
+}
+#endif /* CONFIG_TRACE */
+
+#if CONFIG_SCHED_POLICY == SCHED_POLICY_PRIORITY
+static inline uint32_t task_threshold(uint32_t task_id)
+{
+	return (tasks[task_id].preempt_threshold > tasks[task_id].priority) ?
+			tasks[task_id].preempt_threshold : tasks[task_id].priority;
+}
+
+/*
+ * Priority used for selection, doubled to order ties: a task which was switched in and didn't block since then
+ * runs at its threshold and wins over tasks with priority equal to the threshold. Tasks without threshold
+ * compete with their priority, so equal priorities are taken round-robin.
+ */
+static inline uint32_t effective_priority(uint32_t task_id)
+{
+	if (tasks[task_id].threshold_active && task_threshold(task_id) > tasks[task_id].priority)
+		return task_threshold(task_id) * 2 + 1;
+	return tasks[task_id].priority * 2U;
+}
+
+/**
+ * @brief Select TASK_READY task with the highest effective priority, equal ones are taken round-robin
+ *        starting after the current task. A started task is preempted only by priorities above its threshold,
+ *        also when it was preempted by such task and competes again after it.
+ */
+static uint32_t select_highest_priority_task(void)
+{
+	uint32_t selected = IDLE_TASK_ID;
+	uint32_t task_id = current_task;
+	for (int i = 0; i < MAX_TASKS; i++) {
+		task_id = (task_id + 1) % MAX_TASKS;
+		if (task_id == IDLE_TASK_ID || tasks[task_id].current_state != TASK_READY)
+			continue;
+		if (selected == IDLE_TASK_ID || effective_priority(task_id) > effective_priority(selected))
+			selected = task_id;
+	}
+	if (selected != IDLE_TASK_ID)
+		tasks[selected].threshold_active = 1;
+	return selected;
+}
+
+#if CONFIG_STATS
+/* A ready task with higher priority than the selected one was held off by the selected task's threshold */
+static uint32_t is_preemption_avoided(uint32_t selected)
+{
+	if (selected == IDLE_TASK_ID)
+		return 0;
+	for (int i = 1; i < MAX_TASKS; i++) { // Skip idle task
+		if (tasks[i].current_state == TASK_READY && tasks[i].priority > tasks[selected].priority)
+			return 1;
 	}
+	return 0;
 }
+#endif
+#endif /* CONFIG_SCHED_POLICY == SCHED_POLICY_PRIORITY */
 
 /**
  * @brief Main function: initialize:
  *                       - System Fault exception handlers
  *                       - SysTick timer and PendSV (context switch) handlers
- *                       - 4 user tasks and runs them in Thread mode starting from task 1.
+ *                       - all tasks of KERNEL_TASK_LIST and runs them in Thread mode starting from the first user task.
+ * @return -1 if admission control rejected the task list, doesn't return otherwise.
  */
-void init_and_run_scheduler(void)
+int32_t init_and_run_scheduler(void)
 {
+#if CONFIG_ADMISSION_CONTROL
+	// Periodic tasks of the task list must be schedulable, a rejected set doesn't start:
+	if (admit_task_set() != 0)
+		return -1;
+#endif
 	enable_all_configurable_exceptions();
 	init_scheduler_stack((uint32_t *)SCHEDULER_STACK_START);
 	init_tasks(MAX_TASKS);
 	initial_systick_config();
-	change_sp_to_psp();
-	current_task = 1;
-	task_1_handler();
+#if CONFIG_TASK_BUDGETS
+	last_charge_us = kernel_now_us();
+#endif
+#if CONFIG_HW_COUNTERS
+	dwt_cycle_counter_enable();
+	last_harvest = dwt_get_cycles();
+#endif
+#if CONFIG_SCHED_POLICY == SCHED_POLICY_CYCLIC
+	current_task = cyclic_table[0].task_id;	// owner of frame 0, task_idle if the frame is free
+#else
+	current_task = FIRST_TASK_ID;
+#endif
+	change_sp_to_psp();	// PSP of current_task: the first PendSV saves the context of the task running here
+	scheduler_running = 1;
+	tasks[current_task].handler();
 
 	// Should never come here!!!
 	// Can't exit from this function to MAIN because SP was changed from MSP to PSP, so
-	// return will cause stack corruption or fault.
+	// return will cause stack corruption or fault. Only host simulator tasks return here.
+	return 0;
+}
+
+/* Task waits for its block_count tick */
+static inline uint32_t is_sleeping(uint32_t task_id)
+{
+	return tasks[task_id].current_state == TASK_BLOCKED || tasks[task_id].current_state == TASK_WAITING;
+}
+
+/**
+ * @brief Choose wakeup tick in [deadline, deadline + slack]: the earliest tick on which another task already
+ *        wakes up, otherwise the first tick aligned to the largest power of 2 not above slack + 1, so tasks with
+ *        similar slack meet on the same ticks. One SysTick then releases all of them with one context switch.
+ */
+static uint32_t coalesce_wakeup(uint32_t deadline, uint32_t slack)
+{
+	uint32_t best = 0, found = 0;
+	for (int i = 1; i < MAX_TASKS; i++) {
+		uint32_t offset = tasks[i].block_count - deadline;
+		if (i != current_task && is_sleeping(i) && offset <= slack &&
+				(!found || offset < best)) {
+			best = offset;
+			found = 1;
+		}
+	}
+	if (found) {
+#if CONFIG_STATS
+		if (best != 0)	// a wakeup on the deadline itself is not moved by slack
+			merged_wakeups++;
+#endif
+		return deadline + best;
+	}
+	uint32_t align = (slack >= 0x7FFFFFFFU) ? 0x80000000U : 1U << (31 - __builtin_clz(slack + 1));
+	return (deadline + align - 1) & ~(align - 1);
+}
+
+/**
+ * @brief Move current task to "state" (TASK_BLOCKED or TASK_WAITING) till "ticks" (+ up to "slack") pass.
+ *        Interrupts are not masked: SysTick looks only at sleeping tasks, so block_count is written before the
+ *        state is published. If a tick came between reading the tick count and blocking and the wakeup tick is
+ *        already reached, the task stays ready.
+ */
+static void block_current_task(uint32_t state, uint32_t ticks, uint32_t slack)
+{
+	TCB_t *task = &tasks[current_task];
+	uint32_t now = global_tick_count;
+	task->block_count = (slack != 0) ? coalesce_wakeup(now + ticks, slack) : now + ticks;
+	task->threshold_active = 0;
+	atomic_store(&task->current_state, state);
+	if (global_tick_count - now >= task->block_count - now)
+		atomic_cas(&task->current_state, state, TASK_READY);
 }
 
 /**
  * @brief     Sleep for requested scheduler ticks
- * @param[in] tick_count - number of scheduler ticks. Each tick equals to TASK_DURAION time.
+ * @param[in] tick_count - number of scheduler ticks. Each tick equals to 1 / CONFIG_TICK_RATE_HZ seconds.
  */
 void delay_task(uint32_t tick_count) {
-	INTERRUPT_DISABLE();	// Disable interrupts because current task and tasks are global and next modification
-							// should be atomic
+	delay_task_slack(tick_count, 0);
+}
+
+/**
+ * @brief     Sleep for at least "tick_count" and at most "tick_count + slack" scheduler ticks. Kernel moves the
+ *            wakeup inside the slack to a tick shared with other sleeping tasks.
+ * @param[in] tick_count - minimal number of scheduler ticks to sleep.
+ * @param[in] slack - tolerated extra delay in ticks.
+ */
+void delay_task_slack(uint32_t tick_count, uint32_t slack) {
 	if (current_task != IDLE_TASK_ID) {
-		// Block current task:
-		tasks[current_task].block_count = global_tick_count + tick_count;
-		tasks[current_task].current_state = TASK_BLOCKED;
+		block_current_task(TASK_BLOCKED, tick_count, slack);
 		// Trigger scheduler:
 		schedule();
 	}
-	INTERRUPT_ENABLE();
+}
+
+/**
+ * @brief     Block current task till it is notified by task_notify() or timeout expires.
+ *            If notification is already pending, returns immediately.
+ * @param[in] timeout - number of scheduler ticks to wait, WAIT_FOREVER to wait without timeout.
+ * @return    1 if task was notified, 0 on timeout.
+ */
+uint32_t task_wait_notify(uint32_t timeout) {
+	TCB_t *task = &tasks[current_task];
+	if (current_task != IDLE_TASK_ID && atomic_load(&task->notify_pending) == 0 && timeout != 0) {
+		if (timeout == WAIT_FOREVER) {
+			task->threshold_active = 0;
+			atomic_store(&task->current_state, TASK_SUSPENDED);
+		} else {
+			block_current_task(TASK_WAITING, timeout, 0);
+		}
+		// task_notify() sets notify_pending before it looks at the state, so a notification which came after
+		// the check above is seen here and is not lost:
+		if (atomic_load(&task->notify_pending))
+			atomic_store(&task->current_state, TASK_READY);
+		schedule();	// PendSV switches the task out here till it becomes TASK_READY again
+	}
+	return atomic_swap(&task->notify_pending, 0);
+}
+
+/* Request a context switch for a task which was just made TASK_READY */
+static void schedule_woken_task(uint32_t task_id)
+{
+	// From ISR let the woken task run as soon as the interrupt returns, task context keeps running its slice
+	// unless the woken task may preempt it:
+	if (is_in_handler_mode())
+		schedule();
+#if CONFIG_SCHED_POLICY == SCHED_POLICY_PRIORITY
+	else if (tasks[task_id].priority * 2U > effective_priority(current_task))
+		schedule();
+#else
+	(void)task_id;
+#endif
+}
+
+/**
+ * @brief     Notify a task and make it TASK_READY if it waits in task_wait_notify(). Can be called from ISR.
+ * @param[in] task_id - index of the task to notify.
+ */
+void task_notify(uint32_t task_id) {
+	if (task_id == IDLE_TASK_ID || task_id >= MAX_TASKS)
+		return;
+	atomic_store(&tasks[task_id].notify_pending, 1);
+	// Tasks sleeping in delay_task() (TASK_BLOCKED) keep sleeping, they see the notification later:
+	if (atomic_cas(&tasks[task_id].current_state, TASK_SUSPENDED, TASK_READY) ||
+			atomic_cas(&tasks[task_id].current_state, TASK_WAITING, TASK_READY))
+		schedule_woken_task(task_id);
+}
+
+/**
+ * @brief     Suspend current task till task_resume() is called and "wake_flag" is set.
+ */
+void task_suspend_until(const volatile uint32_t *wake_flag) {
+	TCB_t *task = &tasks[current_task];
+	if (current_task == IDLE_TASK_ID)
+		return;
+	// task_notify() also resumes suspended tasks, so sleep again till the flag is really set:
+	while (atomic_load((volatile uint32_t *)wake_flag) == 0) {
+		task->threshold_active = 0;
+		atomic_store(&task->current_state, TASK_SUSPENDED);
+		// Waker sets the flag before task_resume() looks at the state, so a wakeup after the check is not lost:
+		if (atomic_load((volatile uint32_t *)wake_flag))
+			atomic_store(&task->current_state, TASK_READY);
+		schedule();
+	}
+}
+
+/**
+ * @brief     Make task TASK_READY if it is suspended in task_suspend_until(). Can be called from ISR.
+ */
+void task_resume(uint32_t task_id) {
+	if (task_id == IDLE_TASK_ID || task_id >= MAX_TASKS)
+		return;
+	if (atomic_cas(&tasks[task_id].current_state, TASK_SUSPENDED, TASK_READY))
+		schedule_woken_task(task_id);
+}
+
+/**
+ * @brief     Change task priority and preemption threshold at run time (SCHED_POLICY_PRIORITY).
+ * @param[in] task_id - index of the task.
+ * @param[in] priority - higher value - higher priority.
+ * @param[in] preempt_threshold - task is preempted only by priorities above it, values below priority mean priority.
+ */
+void task_set_priority(uint32_t task_id, uint8_t priority, uint8_t preempt_threshold) {
+	if (task_id == IDLE_TASK_ID || task_id >= MAX_TASKS)
+		return;
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	uint8_t *task_priority = &tasks[task_id].priority;
+#if CONFIG_TASK_BUDGETS
+	// Aperiodic server out of budget gets the new priority on replenishment:
+	if (tasks[task_id].budget_demoted)
+		task_priority = &tasks[task_id].budget_priority;
+#endif
+	*task_priority = priority;
+	tasks[task_id].preempt_threshold = preempt_threshold;
+	INTERRUPT_RESTORE(state);
+	if (scheduler_running)
+		schedule();
+}
+
+/**
+ * @brief     Get current scheduler tick.
+ * @return    number of scheduler ticks since scheduler start.
+ */
+uint32_t get_tick_count(void) {
+	return global_tick_count;
+}
+
+/**
+ * @brief     Get index of the running task.
+ */
+uint32_t get_current_task_id(void) {
+	return current_task;
+}
+
+/**
+ * @brief     Check if scheduler already started running tasks (blocking calls are allowed).
+ * @return    1 if tasks are running, 0 before init_and_run_scheduler() switched to tasks.
+ */
+uint32_t is_scheduler_running(void) {
+	return scheduler_running;
 }
 
 /**
@@ -87,21 +611,223 @@ void update_global_tick_count(void) {
 
 /**
  * @brief     Check if any of tasks should be unlocked on current scheduler tick.
+ * @return    number of tasks released on this tick.
  */
-void update_blocked_tasks(void) {
+uint32_t update_blocked_tasks(void) {
+	uint32_t released = 0;
 	for (int i = 1; i < MAX_TASKS; i++) // Skip idle task
 	{
-		if (tasks[i].current_state == TASK_BLOCKED)
+		uint32_t state = tasks[i].current_state;
+		// Under the cyclic executive delay_task() ends the job, only the schedule table releases it:
+		if (state == TASK_WAITING || (state == TASK_BLOCKED && CONFIG_SCHED_POLICY != SCHED_POLICY_CYCLIC))
 		{
+			// CAS: a waiting task could be made ready by task_notify() from a higher priority interrupt
 			if (tasks[i].block_count == global_tick_count)
-			{
-				tasks[i].block_count = 0;
-				tasks[i].current_state = TASK_READY;
-			}
+				released += atomic_cas(&tasks[i].current_state, state, TASK_READY);
 		}
 	}
+	return released;
+}
+
+/**
+ * @brief     Check if the running task has to share the CPU with another ready task on this tick (time slicing).
+ *            If not and no task was released, SysTick doesn't need a context switch.
+ */
+uint32_t is_time_slice_due(void) {
+	for (int i = 1; i < MAX_TASKS; i++) {
+		if (i == current_task || tasks[i].current_state != TASK_READY)
+			continue;
+#if CONFIG_SCHED_POLICY == SCHED_POLICY_PRIORITY
+		if (current_task == IDLE_TASK_ID || tasks[i].priority * 2U >= effective_priority(current_task))
+			return 1;
+#else
+		return 1;
+#endif
+	}
+	return 0;
+}
+
+#if CONFIG_TASK_BUDGETS
+/**
+ * @brief     Charge the running task and replenish budgets of tasks whose period starts on this tick.
+ *            Unused budget is not carried over, time a throttled task used above its budget is taken from the
+ *            next period.
+ * @return    1 if a throttled task was released or the running task used up its budget.
+ */
+uint32_t update_task_budgets(void)
+{
+	uint32_t switch_due = 0;
+	charge_running_task();
+	for (int i = 1; i < MAX_TASKS; i++) {
+		TCB_t *task = &tasks[i];
+		if (task->budget_period == 0 || task->replenish_tick != global_tick_count)
+			continue;
+		// Time a demoted server ran at its fallback priority is not taken from the new budget:
+		if (task->budget_demoted || task->budget_used_us < task->budget_us)
+			task->budget_used_us = 0;
+		else
+			task->budget_used_us -= task->budget_us;
+		task->replenish_tick += task->budget_period;
+		if (task->budget_used_us < task->budget_us) {
+			switch_due |= atomic_cas(&task->current_state, TASK_THROTTLED, TASK_READY);
+			switch_due |= restore_budget_priority(task);
+		}
+	}
+	return switch_due | is_over_budget(current_task);
+}
+
+/**
+ * @brief     Set CPU budget of the task: "budget_us" of running time every "period_ticks" ticks, starting with a
+ *            full budget now.
+ * @param[in] task_id - index of the task.
+ * @param[in] budget_us - CPU time per period in microseconds, 0 removes the budget.
+ * @param[in] period_ticks - replenishment period in scheduler ticks.
+ */
+void task_set_budget(uint32_t task_id, uint32_t budget_us, uint32_t period_ticks)
+{
+	if (task_id == IDLE_TASK_ID || task_id >= MAX_TASKS)
+		return;
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	TCB_t *task = &tasks[task_id];
+	task->budget_us = budget_us;
+	task->budget_period = (budget_us != 0) ? period_ticks : 0;
+	task->budget_used_us = 0;
+	task->replenish_tick = global_tick_count + period_ticks;
+	uint32_t released = atomic_cas(&task->current_state, TASK_THROTTLED, TASK_READY);
+	released |= restore_budget_priority(task);
+	INTERRUPT_RESTORE(state);
+	if (released)
+		schedule_woken_task(task_id);
+}
+
+/**
+ * @brief     Get CPU time the task used in its current budget period.
+ */
+uint32_t get_task_budget_used_us(uint32_t task_id)
+{
+	return (task_id < MAX_TASKS) ? tasks[task_id].budget_used_us : 0;
+}
+
+/**
+ * @brief     Get number of times the task used up its budget and was throttled.
+ */
+uint32_t get_task_budget_overruns(uint32_t task_id)
+{
+	return (task_id < MAX_TASKS) ? tasks[task_id].budget_overruns : 0;
+}
+#endif /* CONFIG_TASK_BUDGETS */
+
+#if CONFIG_ADMISSION_CONTROL
+/**
+ * @brief     Declare the task periodic (or not periodic with period_us = 0) and run the admission test of the
+ *            new task set, tasks without period counted with their budgets. If it passes, all periodic tasks get
+ *            their new rate-monotonic priorities; if not, the failing tasks are logged and nothing changes.
+ *            Call from one task at a time.
+ * @param[in] task_id - index of the task.
+ * @param[in] period_us - release period in microseconds, 0 removes the task from the analysis.
+ * @param[in] wcet_us - worst-case execution time of one job in microseconds.
+ * @return    0 if admitted, -1 if rejected.
+ */
+int32_t task_admit(uint32_t task_id, uint32_t period_us, uint32_t wcet_us)
+{
+	if (task_id == IDLE_TASK_ID || task_id >= MAX_TASKS || (period_us != 0 && (wcet_us == 0 || wcet_us > period_us)))
+		return -1;
+	TCB_t *task = &tasks[task_id];
+	uint32_t old_period_us = task->period_us, old_wcet_us = task->wcet_us;
+	task->period_us = period_us;
+	task->wcet_us = wcet_us;
+	if (admit_task_set() != 0) {
+		task->period_us = old_period_us;
+		task->wcet_us = old_wcet_us;
+		return -1;
+	}
+	if (scheduler_running)
+		schedule();
+	return 0;
+}
+
+/**
+ * @brief     Get worst-case response time of the task found by the admission test, 0 if it is not periodic.
+ */
+uint32_t get_task_response_time_us(uint32_t task_id)
+{
+	return (task_id < MAX_TASKS && tasks[task_id].period_us != 0) ? tasks[task_id].response_us : 0;
+}
+
+#if CONFIG_STATS && CONFIG_HR_TIMEBASE
+/**
+ * @brief     Print declared utilization (wcet / period) of every periodic task next to the share of CPU time it
+ *            really used since the previous report.
+ */
+void task_utilization_report(void)
+{
+	uint32_t now_us = kernel_now_us();
+	uint32_t elapsed_us = now_us - report_us;
+	report_us = now_us;
+	printf("task  prio  period_us  wcet_us  resp_us  declared%%   used%%\n");
+	for (uint32_t i = 1; i < MAX_TASKS; i++) {
+		uint32_t run_us = tasks[i].run_time_us;
+		uint64_t run_in_period_us = run_us - report_run_us[i];
+		uint32_t used = (elapsed_us != 0) ? (uint32_t)((run_in_period_us * 1000U) / elapsed_us) : 0;
+		report_run_us[i] = run_us;
+		if (tasks[i].period_us == 0)
+			continue;
+		uint32_t declared = (uint32_t)(((uint64_t)tasks[i].wcet_us * 1000U) / tasks[i].period_us);
+		printf("%-4lu %5lu %10lu %8lu %8lu %7lu.%lu %5lu.%lu%s\n", (unsigned long)i,
+				(unsigned long)tasks[i].priority,
+				(unsigned long)tasks[i].period_us, (unsigned long)tasks[i].wcet_us,
+				(unsigned long)tasks[i].response_us, (unsigned long)(declared / 10), (unsigned long)(declared % 10),
+				(unsigned long)(used / 10), (unsigned long)(used % 10), (used > declared) ? "  over" : "");
+	}
+}
+#endif /* CONFIG_STATS && CONFIG_HR_TIMEBASE */
+#endif /* CONFIG_ADMISSION_CONTROL */
+
+#if CONFIG_SCHED_POLICY == SCHED_POLICY_CYCLIC
+/**
+ * @brief     Called on every scheduler tick instead of update_blocked_tasks(): moves to the next minor frame of the
+ *            schedule table when the current one is over and releases the job which starts in it.
+ *            Tasks end their job with delay_task() or task_wait_notify() without timeout.
+ * @return    1 if a new frame started and its owner has to be switched in.
+ */
+uint32_t cyclic_advance_frame(void)
+{
+	if (++frame_tick < CYCLIC_FRAME_TICKS)
+		return 0;
+	frame_tick = 0;
+
+	// Job which had to finish in this frame is still running: it is switched out and continues only in the
+	// next frames of its own task, so it can't steal the slot of another task:
+	const cyclic_frame_t *frame = &cyclic_table[frame_index];
+	if ((frame->flags & CYCLIC_JOB_END) && frame->task_id != IDLE_TASK_ID &&
+			tasks[frame->task_id].current_state == TASK_READY)
+		frame_overruns[frame_index]++;
+
+	frame_index = (frame_index + 1) % CYCLIC_FRAMES;
+	frame = &cyclic_table[frame_index];
+	if (frame->flags & CYCLIC_JOB_START)
+		atomic_store(&tasks[frame->task_id].current_state, TASK_READY);
+	return 1;
 }
 
+/**
+ * @brief     Get index of the current minor frame in the schedule table.
+ */
+uint32_t get_current_frame(void)
+{
+	return frame_index;
+}
+
+/**
+ * @brief     Get number of times the job planned to finish in the frame overran the frame end.
+ */
+uint32_t get_frame_overrun_count(uint32_t frame)
+{
+	return (frame < CYCLIC_FRAMES) ? frame_overruns[frame] : 0;
+}
+#endif /* CONFIG_SCHED_POLICY == SCHED_POLICY_CYCLIC */
+
 /**
  * @brief     Get PSP stack pointer of currently running task
  * @return    stack pointer of currently running (just before exception) task.
@@ -121,23 +847,161 @@ void save_psp_value(uint32_t *psp_val)
 }
 
 /**
- * @brief     Runs next task selection. If all tasks are in TASK_BLOCKED state, then task_idle runs.
+ * @brief Select the task to run after current_task according to CONFIG_SCHED_POLICY.
  */
-void update_to_next_task(void)
+static uint32_t select_next_task(void)
 {
-	uint32_t task_selected = 0;
+#if CONFIG_SCHED_POLICY == SCHED_POLICY_PRIORITY
+	return select_highest_priority_task();
+#elif CONFIG_SCHED_POLICY == SCHED_POLICY_CYCLIC
+	// Only the owner of the frame may run, the rest of the frame after its job is done is idle:
+	uint32_t owner = cyclic_table[frame_index].task_id;
+	return (tasks[owner].current_state == TASK_READY) ? owner : IDLE_TASK_ID;
+#else
+	uint32_t task_id = current_task;
 	// Loop over tasks till TASK_READY is found
 	for (int i = 0; i < MAX_TASKS; i++) {
-		current_task++;
-		current_task %= MAX_TASKS; // FIXME!!!
-		if (current_task != IDLE_TASK_ID && tasks[current_task].current_state == TASK_READY) {
-			task_selected = 1;
-			break;
-		}
+		task_id = (task_id + 1) % MAX_TASKS;
+		if (task_id != IDLE_TASK_ID && tasks[task_id].current_state == TASK_READY)
+			return task_id;
 	}
 	// If no TASK_READY is found, choose IDLE task
-	if (task_selected == 0)
-		current_task = IDLE_TASK_ID;
+	return IDLE_TASK_ID;
+#endif
+}
+
+/**
+ * @brief     Runs next task selection. If all tasks are in TASK_BLOCKED state, then task_idle runs.
+ */
+void update_to_next_task(void)
+{
+#if CONFIG_STACK_CHECK || CONFIG_TRACE || (CONFIG_STATS && CONFIG_HR_TIMEBASE) || CONFIG_HW_COUNTERS || \
+		CONFIG_TASK_BUDGETS
+	uint32_t prev_task = current_task;
+#endif
+#if CONFIG_HW_COUNTERS
+	harvest_task_hw_counters(prev_task);
+#endif
+#if CONFIG_STACK_CHECK
+	check_task_stack(prev_task);
+#endif
+#if CONFIG_TASK_BUDGETS
+	charge_running_task();
+	throttle_if_exhausted(prev_task);
+	// A selected task which is out of budget is throttled, selection goes on after it:
+	do {
+		current_task = select_next_task();
+	} while (throttle_if_exhausted(current_task));
+#else
+	current_task = select_next_task();
+#endif
+#if CONFIG_STATS && CONFIG_SCHED_POLICY == SCHED_POLICY_PRIORITY
+	// Counted once for the final selection, selection may run again after throttling a task:
+	preemptions_avoided += is_preemption_avoided(current_task);
+#endif
+
+#if CONFIG_STATS && CONFIG_HR_TIMEBASE
+	// Time since the previous switch belongs to the task which is switched out:
+	uint32_t now_us = kernel_now_us();
+	tasks[prev_task].run_time_us += now_us - last_switch_us;
+	last_switch_us = now_us;
+#endif
+#if CONFIG_STATS
+	tasks[current_task].switch_count++;
+	context_switch_count++;
+#endif
+#if CONFIG_TRACE
+	trace_task_switch(prev_task, current_task);
+#endif
+}
+
+#if CONFIG_STATS
+/**
+ * @brief     Get number of times the task was switched in.
+ */
+uint32_t get_task_switch_count(uint32_t task_id)
+{
+	return (task_id < MAX_TASKS) ? tasks[task_id].switch_count : 0;
+}
+
+/**
+ * @brief     Get total number of context switches (PendSV runs) since scheduler start.
+ */
+uint32_t get_context_switch_count(void)
+{
+	return context_switch_count;
+}
+
+/**
+ * @brief     Get number of task selections where a higher priority ready task didn't preempt the running one
+ *            because of its preemption threshold.
+ */
+uint32_t get_preemptions_avoided_count(void)
+{
+	return preemptions_avoided;
+}
+
+/**
+ * @brief     Get number of wakeups moved within their slack onto a tick where another task wakes up.
+ */
+uint32_t get_merged_wakeup_count(void)
+{
+	return merged_wakeups;
+}
+
+#if CONFIG_HR_TIMEBASE
+/**
+ * @brief     Get total time the task was running in microseconds.
+ */
+uint32_t get_task_run_time_us(uint32_t task_id)
+{
+	return (task_id < MAX_TASKS) ? tasks[task_id].run_time_us : 0;
+}
+#endif /* CONFIG_HR_TIMEBASE */
+#endif /* CONFIG_STATS */
+
+#if CONFIG_HW_COUNTERS
+/**
+ * @brief     Add DWT counts since the last harvest to the running task. Called by SysTick.
+ */
+void harvest_hw_counters(void)
+{
+	harvest_task_hw_counters(current_task);
+}
+
+/**
+ * @brief     Copy DWT counts accumulated while the task was running.
+ */
+void get_task_hw_counters(uint32_t task_id, task_hw_counters_t *counters)
+{
+	uint32_t state;
+	if (task_id >= MAX_TASKS)
+		return;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	*counters = tasks[task_id].hw_counters;
+	INTERRUPT_RESTORE(state);
 }
 
+static inline unsigned long percent_of(uint64_t part, uint64_t total)
+{
+	return (total != 0) ? (unsigned long)(part * 100U / total) : 0;
+}
 
+/**
+ * @brief     Print per task share of all cycles.
+ */
+void task_hw_counters_report(void)
+{
+	task_hw_counters_t c[MAX_TASKS];
+	uint64_t total = 0;
+	for (uint32_t i = 0; i < MAX_TASKS; i++) {
+		get_task_hw_counters(i, &c[i]);
+		total += c[i].cycles;
+	}
+	printf("task    cpu%%  kcycles\n");
+	for (uint32_t i = 0; i < MAX_TASKS; i++) {
+		printf("%-4lu %6lu %8lu\n", (unsigned long)i, percent_of(c[i].cycles, total),
+				(unsigned long)(c[i].cycles / 1000U));
+	}
+}
+#endif /* CONFIG_HW_COUNTERS */
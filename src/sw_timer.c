@@ -0,0 +1,206 @@
+/*
+ * sw_timer.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+#include "kernel_config.h"
+#if CONFIG_SW_TIMERS
+#include "sw_timer.h"
+#include "scheduler.h"
+#include "hal_and_isrs.h"
+
+/* ======================== GLOBAL STATE ==================================*/
+// Min-heap of running timers, heap[0] expires first:
+static sw_timer_t *heap[SW_TIMER_MAX];
+static uint32_t heap_size = 0;
+
+/* ========================================================================*/
+
+/* Tick counter wraps, so compare ticks by signed difference */
+static inline uint32_t tick_before(uint32_t a, uint32_t b)
+{
+	return (int32_t)(a - b) < 0;
+}
+
+static void heap_place(uint32_t i, sw_timer_t *timer)
+{
+	heap[i] = timer;
+	timer->heap_index = i;
+}
+
+static void heap_sift_up(uint32_t i)
+{
+	sw_timer_t *timer = heap[i];
+	while (i > 0) {
+		uint32_t parent = (i - 1) / 2;
+		if (!tick_before(timer->expiry, heap[parent]->expiry))
+			break;
+		heap_place(i, heap[parent]);
+		i = parent;
+	}
+	heap_place(i, timer);
+}
+
+static void heap_sift_down(uint32_t i)
+{
+	sw_timer_t *timer = heap[i];
+	while (1) {
+		uint32_t child = 2 * i + 1;
+		if (child >= heap_size)
+			break;
+		if (child + 1 < heap_size && tick_before(heap[child + 1]->expiry, heap[child]->expiry))
+			child++;
+		if (!tick_before(heap[child]->expiry, timer->expiry))
+			break;
+		heap_place(i, heap[child]);
+		i = child;
+	}
+	heap_place(i, timer);
+}
+
+/* Must be called with interrupts disabled */
+static int heap_insert(sw_timer_t *timer)
+{
+	if (heap_size >= SW_TIMER_MAX)
+		return -1;
+	heap_place(heap_size, timer);
+	heap_size++;
+	heap_sift_up(timer->heap_index);
+	return 0;
+}
+
+/* Must be called with interrupts disabled */
+static void heap_remove(sw_timer_t *timer)
+{
+	uint32_t i = timer->heap_index;
+	timer->heap_index = -1;
+	heap_size--;
+	if (i == heap_size)
+		return;
+	// Put last element to the free place and restore heap order in the needed direction:
+	heap_place(i, heap[heap_size]);
+	if (i > 0 && tick_before(heap[i]->expiry, heap[(i - 1) / 2]->expiry))
+		heap_sift_up(i);
+	else
+		heap_sift_down(i);
+}
+
+/**
+ * @brief     Initialize timer descriptor. Timer is not started.
+ */
+void sw_timer_init(sw_timer_t *timer, sw_timer_mode_t mode, uint32_t period,
+		sw_timer_callback_t callback, void *arg)
+{
+	timer->expiry = 0;
+	timer->period = period;
+	timer->mode = mode;
+	timer->callback = callback;
+	timer->arg = arg;
+	timer->heap_index = -1;
+}
+
+/**
+ * @brief     Start or restart timer: it expires after "period" ticks from now. Can be called from ISR.
+ * @return    0 on success, -1 if there is no space for one more running timer.
+ */
+int sw_timer_start(sw_timer_t *timer)
+{
+	int ret = 0;
+	uint32_t state;
+	if (timer->period == 0)
+		return -1;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	if (timer->heap_index >= 0)
+		heap_remove(timer);
+	timer->expiry = get_tick_count() + timer->period;
+	ret = heap_insert(timer);
+	INTERRUPT_RESTORE(state);
+	return ret;
+}
+
+/**
+ * @brief     Stop timer. Does nothing if timer is not running. Can be called from ISR.
+ */
+void sw_timer_stop(sw_timer_t *timer)
+{
+	uint32_t state;
+	INTERRUPT_SAVE_AND_DISABLE(state);
+	if (timer->heap_index >= 0)
+		heap_remove(timer);
+	INTERRUPT_RESTORE(state);
+}
+
+/**
+ * @brief     Change timer period and restart it with the new period. Can be called from ISR.
+ * @return    0 on success, -1 if period is 0 or timer can't be started.
+ */
+int sw_timer_change_period(sw_timer_t *timer, uint32_t period)
+{
+	if (period == 0)
+		return -1;
+	timer->period = period;
+	return sw_timer_start(timer);
+}
+
+/**
+ * @brief     Check if timer is running.
+ * @return    1 if timer is running, 0 otherwise.
+ */
+uint32_t sw_timer_is_active(const sw_timer_t *timer)
+{
+	return timer->heap_index >= 0;
+}
+
+/**
+ * @brief     Called on every scheduler tick. Wakes timer service task if the earliest timer expired. O(1).
+ * @param[in] now - current scheduler tick.
+ */
+void sw_timer_check_expired(uint32_t now)
+{
+	if (heap_size > 0 && !tick_before(now, heap[0]->expiry))
+		task_notify(TIMER_TASK_ID);
+}
+
+/**
+ * @brief     Pop all expired timers one by one and run their callbacks with interrupts enabled,
+ *            so callbacks can use the timer API themselves.
+ */
+static void process_expired_timers(void)
+{
+	uint32_t state;
+	while (1) {
+		sw_timer_t *timer;
+		INTERRUPT_SAVE_AND_DISABLE(state);
+		uint32_t now = get_tick_count();
+		if (heap_size == 0 || tick_before(now, heap[0]->expiry)) {
+			INTERRUPT_RESTORE(state);
+			break;
+		}
+		timer = heap[0];
+		heap_remove(timer);
+		if (timer->mode == SW_TIMER_AUTO_RELOAD) {
+			// Keep the phase of the timer. If callbacks took too long, skip missed periods:
+			timer->expiry += timer->period;
+			if (!tick_before(now, timer->expiry))
+				timer->expiry = now + timer->period;
+			heap_insert(timer); // can't fail: the place was just released
+		}
+		INTERRUPT_RESTORE(state);
+
+		timer->callback(timer, timer->arg);
+	}
+}
+
+/**
+ * @brief     Timer service task. Runs callbacks of all expired timers on its own stack.
+ */
+void sw_timer_service_task(void)
+{
+	while (1) {
+		task_wait_notify(WAIT_FOREVER);
+		process_expired_timers();
+	}
+}
+
+#endif /* CONFIG_SW_TIMERS */
@@ -6,6 +6,10 @@
  */
 #include "led_controller.h"
 #include "scheduler.h"
+#include "binlog.h"
+
+// Blink period may be late by up to 50 ms, so the kernel can release several LED tasks on one tick:
+#define LED_BLINK_SLACK (DELAY_1S / 20)
 
 /**
  * @brief Idle task runs when all other taks are in TASK_BLOCKED state
@@ -15,6 +19,19 @@ void task_idle(void)
 	while(1);
 }
 
+#if CONFIG_LED_ENGINE
+/**
+ * @brief Start the LED demo on the LED engine: same periods as the blinker tasks, no task and no tick involved.
+ */
+void start_led_blinkers(void)
+{
+	led_blink(LED_GREEN, 1000, 1000);
+	led_blink(LED_ORANGE, 2000, 2000);
+	led_blink(LED_RED, 4000, 4000);
+	led_blink(LED_BLUE, 8000, 8000);
+}
+#else
+
 /**
  * @brief User task handler. Can be populated with anything.
  *	  Current example turns on and off a led with specific period. 
@@ -23,12 +40,12 @@ void task_1_handler(void)
 {
 	while(1) {
 	#if (defined(DEBUG_ON) && defined(OPENOCD_SEMIHOSTING_ENABLED))
-		printf("%s\n", __func__);
+		LOG("%s", __func__);
 	#endif
 		turn_led(LED_GREEN, LED_ON);
-		delay_task(DELAY_1S);
+		delay_task_slack(DELAY_1S, LED_BLINK_SLACK);
 		turn_led(LED_GREEN, LED_OFF);
-		delay_task(DELAY_1S);
+		delay_task_slack(DELAY_1S, LED_BLINK_SLACK);
 	}
 }
 
@@ -40,12 +57,12 @@ void task_2_handler(void)
 {
 	while(1) {
 	#if (defined(DEBUG_ON) && defined(OPENOCD_SEMIHOSTING_ENABLED))
-		printf("%s\n", __func__);
+		LOG("%s", __func__);
 	#endif
 		turn_led(LED_ORANGE, LED_ON);
-		delay_task(DELAY_2S);
+		delay_task_slack(DELAY_2S, LED_BLINK_SLACK);
 		turn_led(LED_ORANGE, LED_OFF);
-		delay_task(DELAY_2S);
+		delay_task_slack(DELAY_2S, LED_BLINK_SLACK);
 	}
 }
 
@@ -57,12 +74,12 @@ void task_3_handler(void)
 {
 	while(1) {
 	#if (defined(DEBUG_ON) && defined(OPENOCD_SEMIHOSTING_ENABLED))
-		printf("%s\n", __func__);
+		LOG("%s", __func__);
 	#endif
 		turn_led(LED_RED, LED_ON);
-		delay_task(DELAY_4S);
+		delay_task_slack(DELAY_4S, LED_BLINK_SLACK);
 		turn_led(LED_RED, LED_OFF);
-		delay_task(DELAY_4S);
+		delay_task_slack(DELAY_4S, LED_BLINK_SLACK);
 	}
 }
 
@@ -74,12 +91,12 @@ void task_4_handler(void)
 {
 	while(1) {
 	#if (defined(DEBUG_ON) && defined(OPENOCD_SEMIHOSTING_ENABLED))
-		printf("%s\n", __func__);
+		LOG("%s", __func__);
 	#endif
 		turn_led(LED_BLUE, LED_ON);
-		delay_task(DELAY_8S);
+		delay_task_slack(DELAY_8S, LED_BLINK_SLACK);
 		turn_led(LED_BLUE, LED_OFF);
-		delay_task(DELAY_8S);
+		delay_task_slack(DELAY_8S, LED_BLINK_SLACK);
 	}
 }
-
+#endif /* CONFIG_LED_ENGINE */
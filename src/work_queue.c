@@ -0,0 +1,126 @@
+/*
+ * work_queue.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ */
+#include "kernel_config.h"
+#if CONFIG_WORK_QUEUE
+#include "work_queue.h"
+#include "scheduler.h"
+#include "atomic.h"
+
+/* ======================== GLOBAL STATE ==================================*/
+WORK_QUEUE_DEFINE(sys_workq)
+
+/* ========================================================================*/
+
+static inline uint32_t tick_reached(uint32_t tick, uint32_t now)
+{
+	return (int32_t)(now - tick) >= 0;
+}
+
+/* Lock-free push, safe against ISRs pushing to the same list */
+static void list_push(volatile uint32_t *top, work_t *work)
+{
+	uint32_t old;
+	do {
+		old = atomic_load(top);
+		work->next = (work_t *)old;
+	} while (!atomic_cas(top, old, (uint32_t)work));
+}
+
+/* Take the whole list in submission order (the list is pushed newest first) */
+static work_t *list_take_fifo(volatile uint32_t *top)
+{
+	work_t *lifo = (work_t *)atomic_swap(top, 0);
+	work_t *fifo = NULL;
+	while (lifo != NULL) {
+		work_t *next = lifo->next;
+		lifo->next = fifo;
+		fifo = lifo;
+		lifo = next;
+	}
+	return fifo;
+}
+
+/* Sorted insert into the worker's own list of delayed items, equal due ticks keep submission order */
+static void delayed_insert(work_queue_t *q, work_t *work)
+{
+	work_t **pos = &q->delayed;
+	while (*pos != NULL && tick_reached((*pos)->due_tick, work->due_tick))
+		pos = &(*pos)->next;
+	work->next = *pos;
+	*pos = work;
+}
+
+static int queue_item(volatile uint32_t *top, uint32_t task_id, work_t *work)
+{
+	list_push(top, work);
+	task_notify(task_id);	// pushed before notify, so the worker can't miss it
+	return 0;
+}
+
+int work_submit(work_queue_t *q, work_t *work)
+{
+	if (!atomic_cas(&work->pending, 0, 1))
+		return -1;
+	return queue_item(&q->submitted, q->task_id, work);
+}
+
+int work_submit_delayed(work_queue_t *q, work_t *work, uint32_t delay_ticks)
+{
+	if (delay_ticks == 0)
+		return work_submit(q, work);
+	if (!atomic_cas(&work->pending, 0, 1))
+		return -1;
+	work->due_tick = get_tick_count() + delay_ticks;
+	return queue_item(&q->delayed_in, q->task_id, work);
+}
+
+uint32_t work_is_pending(const work_t *work)
+{
+	return atomic_load(&work->pending);
+}
+
+/**
+ * @brief     Worker loop. Every wakeup takes all submitted items and the due delayed ones as one batch.
+ */
+void work_queue_run(work_queue_t *q)
+{
+	while (1) {
+		uint32_t now = get_tick_count();
+		for (work_t *w = list_take_fifo(&q->delayed_in); w != NULL; ) {
+			work_t *next = w->next;
+			delayed_insert(q, w);
+			w = next;
+		}
+
+		// Batch: submitted items, then due delayed ones
+		work_t *batch = list_take_fifo(&q->submitted);
+		work_t **tail = &batch;
+		while (*tail != NULL)
+			tail = &(*tail)->next;
+		while (q->delayed != NULL && tick_reached(q->delayed->due_tick, now)) {
+			*tail = q->delayed;
+			q->delayed = q->delayed->next;
+			tail = &(*tail)->next;
+		}
+		*tail = NULL;
+
+		if (batch == NULL) {
+			task_wait_notify((q->delayed != NULL) ? q->delayed->due_tick - now : WAIT_FOREVER);
+			continue;
+		}
+		q->batches++;
+		while (batch != NULL) {
+			work_t *w = batch;
+			batch = w->next;
+			atomic_store(&w->pending, 0);
+			w->fn(w);
+			q->executed++;
+		}
+	}
+}
+
+#endif /* CONFIG_WORK_QUEUE */
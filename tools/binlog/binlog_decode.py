@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""
+Decoder of the deferred formatting logger (include/binlog.h).
+
+Pulls binlog_buffer from the running target through GDB + OpenOCD or reads a raw dump, takes the format strings
+from the .logstr section of the ELF file and prints the messages oldest first:
+
+    python3 tools/binlog/binlog_decode.py build/scheduler.elf                 # dump over GDB, OpenOCD on :3333
+    python3 tools/binlog/binlog_decode.py build/scheduler.elf -d log.bin      # use an existing dump
+"""
+import argparse
+import os
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+
+BINLOG_MAGIC = 0x474F4C42
+HEADER_WORDS = 4            # magic, n_records, timestamp_hz, head
+RECORD_WORDS = 8            # seq, fmt, timestamp, 5 args
+SHT_SYMTAB = 2
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+CONVERSION_RE = re.compile(r'%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diouxXcsp%])')
+
+
+class Elf:
+    """Sections and symbols of a 32-bit little-endian ELF file, enough to find strings and variables."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF' or self.data[4] != 1:
+            sys.exit('%s is not a 32-bit ELF file' % path)
+        shoff, = struct.unpack_from('<I', self.data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', self.data, 0x2E)
+        headers = [struct.unpack_from('<10I', self.data, shoff + i * shentsize) for i in range(shnum)]
+        names = headers[shstrndx]
+        self.sections = {}
+        for h in headers:
+            name = self.cstring(names[4] + h[0])
+            self.sections[name] = h     # name, type, flags, addr, offset, size, link, info, align, entsize
+        self.symbols = {}
+        for h in headers:
+            if h[1] == SHT_SYMTAB:
+                strtab = headers[h[6]]
+                for off in range(h[4], h[4] + h[5], 16):
+                    name, value, size = struct.unpack_from('<III', self.data, off)
+                    self.symbols[self.cstring(strtab[4] + name)] = (value, size)
+
+    def cstring(self, offset):
+        return self.data[offset:self.data.index(b'\0', offset)].decode('utf-8', 'replace')
+
+    def logstr(self, addr):
+        section = self.sections.get('.logstr')
+        if section is None or addr >= section[5]:
+            return None
+        return self.cstring(section[4] + addr)
+
+    def string_at(self, addr):
+        """String the target has at "addr", from a section loaded to the target (flash or SRAM copy of .data)."""
+        for h in self.sections.values():
+            if h[2] & SHF_ALLOC and h[1] != SHT_NOBITS and h[3] <= addr < h[3] + h[5]:
+                return self.cstring(h[4] + addr - h[3])
+        return None
+
+
+def dump_over_gdb(elf, gdb, remote, out):
+    if 'binlog_buffer' not in elf.symbols:
+        sys.exit('binlog_buffer is not in the ELF file, build with CONFIG_BINLOG=1')
+    addr, size = elf.symbols['binlog_buffer']
+    subprocess.run([gdb, '-batch', '-nx',
+                    '-ex', 'target extended-remote ' + remote,
+                    '-ex', 'dump binary memory %s 0x%x 0x%x' % (out, addr, addr + size),
+                    '-ex', 'detach'], check=True, stdout=subprocess.DEVNULL)
+
+
+def format_message(elf, fmt, args):
+    """printf of the target, done on host with 32-bit argument words."""
+    args = list(args)
+    out = []
+    pos = 0
+    for m in CONVERSION_RE.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, precision, _, conv = m.groups()
+        if conv == '%':
+            out.append('%')
+            continue
+        value = args.pop(0) if args else 0
+        spec = '%' + flags + width + ('.' + precision if precision else '')
+        if conv in 'di':
+            out.append((spec + 'd') % (value - (1 << 32) if value & 0x80000000 else value))
+        elif conv in 'uoxX':
+            out.append((spec + conv.replace('u', 'd')) % value)
+        elif conv == 'c':
+            out.append((spec + 'c') % chr(value & 0xFF))
+        elif conv == 's':
+            text = elf.string_at(value)
+            out.append((spec + 's') % (text if text is not None else '<0x%08x>' % value))
+        else:
+            out.append('0x%08x' % value)
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+
+def decode(elf, data):
+    magic, n_records, timestamp_hz, head = struct.unpack_from('<%dI' % HEADER_WORDS, data, 0)
+    if magic != BINLOG_MAGIC:
+        sys.exit('binlog_buffer not found in the dump (magic 0x%08x), is CONFIG_BINLOG enabled?' % magic)
+    records = []
+    for i in range(n_records):
+        words = struct.unpack_from('<%dI' % RECORD_WORDS, data, (HEADER_WORDS + i * RECORD_WORDS) * 4)
+        seq = words[0] - 1
+        # Skip records being written, and ones which are not in the slot of their sequence number:
+        if words[0] != 0 and seq % n_records == i and head - n_records <= seq < head:
+            records.append((seq, words[1], words[2], words[3:]))
+    lost = max(0, head - n_records)
+    if lost:
+        print('(%d older messages overwritten)' % lost)
+    for seq, fmt_addr, timestamp, args in sorted(records):
+        fmt = elf.logstr(fmt_addr)
+        text = format_message(elf, fmt, args) if fmt is not None else '<unknown format 0x%x>' % fmt_addr
+        print('[%12.6f] %s' % (timestamp / timestamp_hz, text))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('elf', help='firmware ELF, e.g. build/scheduler.elf')
+    parser.add_argument('-d', '--dump', help='raw dump of binlog_buffer, default: read it over GDB')
+    parser.add_argument('-r', '--remote', default='localhost:3333', help='GDB remote of OpenOCD')
+    parser.add_argument('--gdb', default='arm-none-eabi-gdb')
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+    dump = args.dump
+    if dump is None:
+        fd, dump = tempfile.mkstemp(suffix='.bin')
+        os.close(fd)
+        dump_over_gdb(elf, args.gdb, args.remote, dump)
+    with open(dump, 'rb') as f:
+        decode(elf, f.read())
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+Per-task hot function report of the PC-sampling profiler (include/profiler.h).
+
+Pulls profiler_buffer from the running target through GDB + OpenOCD (the firmware is not halted for longer
+than the memory read) or reads a raw dump, and symbolizes sampled PCs against the ELF file:
+
+    python3 tools/profiler/prof_report.py build/scheduler.elf                 # dump over GDB, OpenOCD on :3333
+    python3 tools/profiler/prof_report.py build/scheduler.elf -d prof.bin     # use an existing dump
+"""
+import argparse
+import bisect
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+
+PROFILER_MAGIC = 0x464F5250
+PROFILER_TASK_ISR = 0xFF
+HEADER_WORDS = 6            # magic, n_tasks, n_slots, enabled, samples, dropped
+
+
+def read_symbols(elf, nm, kinds):
+    """Symbols of the given nm types: name -> (address, size)."""
+    out = subprocess.run([nm, '-S', '--defined-only', elf], check=True, capture_output=True, text=True).stdout
+    symbols = {}
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) == 4 and parts[2] in kinds:
+            addr, size, _, name = parts
+            symbols[name] = (int(addr, 16) & ~1, int(size, 16))     # clear Thumb bit of functions
+    return symbols
+
+
+def dump_over_gdb(elf, gdb, nm, remote, out):
+    # Address and size come from the symbol table, so the ELF doesn't need debug info:
+    buffers = read_symbols(elf, nm, 'dDbB')
+    if 'profiler_buffer' not in buffers:
+        sys.exit('profiler_buffer is not in %s, build with CONFIG_PROFILER=1' % elf)
+    addr, size = buffers['profiler_buffer']
+    subprocess.run([gdb, '-batch', '-nx',
+                    '-ex', 'target extended-remote ' + remote,
+                    '-ex', 'dump binary memory %s 0x%x 0x%x' % (out, addr, addr + size),
+                    '-ex', 'detach',
+                    elf], check=True, stdout=subprocess.DEVNULL)
+
+
+class Symbolizer:
+    def __init__(self, functions):
+        self.table = sorted((addr, size, name) for name, (addr, size) in functions.items())
+        self.starts = [entry[0] for entry in self.table]
+
+    def name(self, pc):
+        i = bisect.bisect_right(self.starts, pc) - 1
+        if i >= 0:
+            addr, size, name = self.table[i]
+            if pc < addr + max(size, 2):
+                return name
+        return '0x%08x' % pc
+
+
+def parse(data):
+    header = struct.unpack_from('<%dI' % HEADER_WORDS, data, 0)
+    magic, n_tasks, n_slots, enabled, samples, dropped = header
+    if magic != PROFILER_MAGIC:
+        sys.exit('profiler_buffer not found in the dump (magic 0x%08x), is CONFIG_PROFILER enabled?' % magic)
+    offset = HEADER_WORDS * 4
+    task_entry = struct.unpack_from('<%dI' % n_tasks, data, offset)
+    offset += n_tasks * 4
+    slots = []
+    for i in range(n_slots):
+        pc, task_plus_1, count = struct.unpack_from('<3I', data, offset + i * 12)
+        if task_plus_1 != 0:
+            slots.append((task_plus_1 - 1, pc, count))
+    return task_entry, slots, samples, dropped, enabled
+
+
+def report(task_entry, slots, samples, dropped, enabled, sym, top):
+    per_task = {}
+    for task, pc, count in slots:
+        per_task.setdefault(task, {})
+        func = sym.name(pc)
+        per_task[task][func] = per_task[task].get(func, 0) + count
+    total = sum(count for _, _, count in slots) or 1
+
+    print('Samples: %d, dropped (table full): %d, sampling %s' % (samples, dropped, 'on' if enabled else 'off'))
+    order = sorted(per_task, key=lambda t: -sum(per_task[t].values()))
+    for task in order:
+        funcs = per_task[task]
+        task_total = sum(funcs.values())
+        if task == PROFILER_TASK_ISR:
+            name = '<interrupts>'
+        elif task < len(task_entry):
+            name = sym.name(task_entry[task] & ~1)
+        else:
+            name = 'task %d' % task
+        print('\n%s: %d samples, %.1f %% of CPU' % (name, task_total, 100.0 * task_total / total))
+        for func, count in sorted(funcs.items(), key=lambda item: -item[1])[:top]:
+            print('  %6.1f %%  %7d  %s' % (100.0 * count / task_total, count, func))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('elf', help='firmware ELF, e.g. build/scheduler.elf')
+    parser.add_argument('-d', '--dump', help='raw dump of profiler_buffer, default: read it over GDB')
+    parser.add_argument('-r', '--remote', default='localhost:3333', help='GDB remote of OpenOCD')
+    parser.add_argument('--gdb', default='arm-none-eabi-gdb')
+    parser.add_argument('--nm', default='arm-none-eabi-nm')
+    parser.add_argument('-n', '--top', type=int, default=10, help='functions per task')
+    args = parser.parse_args()
+
+    dump = args.dump
+    if dump is None:
+        fd, dump = tempfile.mkstemp(suffix='.bin')
+        os.close(fd)
+        dump_over_gdb(args.elf, args.gdb, args.nm, args.remote, dump)
+    with open(dump, 'rb') as f:
+        data = f.read()
+    report(*parse(data), Symbolizer(read_symbols(args.elf, args.nm, 'tTwW')), args.top)
@@ -0,0 +1,23 @@
+/*
+ * hal_and_isrs.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ *
+ * Host replacement of port/hal_and_isrs.h for the scheduling simulator: no interrupts, no stacks switching.
+ * HAL functions used by the kernel are implemented in sched_sim.c.
+ */
+
+#ifndef HAL_AND_ISRS_H_
+#define HAL_AND_ISRS_H_
+#include "common.h"
+
+#define SCHEDULER_STACK_START (0)
+#define STACK_CANARY (0xDEADBEEFU)
+
+#define INTERRUPT_DISABLE() do {} while(0);
+#define INTERRUPT_ENABLE() do {} while(0);
+#define INTERRUPT_SAVE_AND_DISABLE(state) do {(state) = 0;} while(0);
+#define INTERRUPT_RESTORE(state) do {(void)(state);} while(0);
+
+#endif /* HAL_AND_ISRS_H_ */
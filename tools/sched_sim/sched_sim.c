@@ -0,0 +1,576 @@
+/*
+ * sched_sim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ *
+ * Host-side scheduling analysis of a periodic task set:
+ *  1. Utilization and response-time analysis (fixed-priority preemptive model).
+ *  2. Tick-by-tick simulation which runs the kernel's own src/scheduler.c (update_blocked_tasks,
+ *     update_to_next_task, delay_task ...) exactly as SysTick_Handler and PendSV_Handler call it on target.
+ *
+ * Task set file, one task per line, '#' starts a comment. Times are in microseconds, higher priority value
+ * means higher priority. Preemption threshold (default: priority) and stack size (default:
+ * CONFIG_TASK_STACK_SIZE_B) are optional:
+ *     <name> <period_us> <wcet_us> <deadline_us> <priority> [<preempt_threshold> [<stack_bytes>]]
+ *
+ * If any task has a threshold above its priority, the simulation runs twice: with full preemption and with
+ * thresholds, and reports context switches avoided and stack bytes a shared-stack layout of run-to-completion
+ * jobs would save.
+ *
+ * With -g the tool instead generates the schedule table of the cyclic executive (SCHED_POLICY_CYCLIC): the
+ * hyperperiod is cut into minor frames of -f microseconds and every frame is given to one job, earliest deadline
+ * first. Task names must be kernel task entries (e.g. task_1_handler), priorities only break ties.
+ *
+ * -s <percent> lets every task sleep with a slack of that percent of its period (delay_task_slack), so the
+ * kernel coalesces wakeups of tasks with different periods onto shared ticks.
+ *
+ * -m replaces the priorities of the task set with rate-monotonic ones, assigned like the kernel admission control
+ * (CONFIG_ADMISSION_CONTROL) does; the response time analysis is the kernel's src/rta.c.
+ *
+ * Usage: sched_sim [-d duration_s] [-o switch_overhead_us] [-s slack_percent] [-m] <taskset file>
+ *        sched_sim -g <cyclic_table.h> -f <frame_us> <taskset file>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "scheduler.h"
+#include "rta.h"
+
+/* ======================== Kernel HAL implementation for host ============================ */
+extern uint32_t current_task;
+static int switch_pending = 0;
+
+void enable_all_configurable_exceptions(void) {}
+void schedule(void) { switch_pending = 1; }
+void change_sp_to_psp(void) {}
+void initial_systick_config(void) {}
+void init_scheduler_stack(void *start_of_stack) { (void)start_of_stack; }
+void init_task_stack(TCB_t *task_descriptor) { task_descriptor->stack_start -= 16; }
+uint32_t is_in_handler_mode(void) { return 0; }
+
+void task_idle(void) {}
+#define SIM_TASK_DEFINE(entry, stack_size, ...) void entry(void) {}
+CONFIG_USER_TASKS(SIM_TASK_DEFINE)
+
+/* ======================== Task set ====================================================== */
+#define SIM_FIRST_TASK_ID (sim_task_0_id)
+
+typedef struct sim_task_ {
+	char		name[32];
+	uint64_t	period_us;
+	uint64_t	wcet_us;
+	uint64_t	deadline_us;
+	int32_t		priority;
+	int32_t		threshold;
+	uint32_t	stack_bytes;
+
+	// Simulation state and results:
+	uint64_t	release_us;			// release time of the current job
+	uint64_t	remaining_us;		// work left in the current job
+	uint64_t	busy_us;
+	uint64_t	worst_response_us;
+	uint32_t	jobs;
+	uint32_t	misses;
+	uint64_t	rta_us;				// 0 - not schedulable
+} sim_task_t;
+
+static sim_task_t taskset[SIM_MAX_TASKS];
+static uint32_t n_tasks = 0;
+
+static int load_taskset(const char *path)
+{
+	char line[256];
+	FILE *f = fopen(path, "r");
+	if (f == NULL) {
+		perror(path);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f) != NULL) {
+		char *comment = strchr(line, '#');
+		if (comment != NULL)
+			*comment = '\0';
+		sim_task_t t = {0};
+		unsigned long long period, wcet, deadline;
+		t.threshold = -1;
+		t.stack_bytes = CONFIG_TASK_STACK_SIZE_B;
+		int n = sscanf(line, "%31s %llu %llu %llu %d %d %u", t.name, &period, &wcet, &deadline, &t.priority,
+				&t.threshold, &t.stack_bytes);
+		if (n <= 0)
+			continue;
+		if (n < 5 || period == 0 || wcet == 0 || deadline == 0 || t.priority < 0 || t.priority > 255 ||
+				t.threshold > 255 || period > UINT32_MAX || wcet > UINT32_MAX || deadline > UINT32_MAX) {
+			fprintf(stderr, "%s: bad line: %s", path, line);
+			fclose(f);
+			return -1;
+		}
+		if (n_tasks == SIM_MAX_TASKS) {
+			fprintf(stderr, "%s: more than %d tasks\n", path, SIM_MAX_TASKS);
+			fclose(f);
+			return -1;
+		}
+		t.period_us = period;
+		t.wcet_us = wcet;
+		t.deadline_us = deadline;
+		if (t.threshold < t.priority)
+			t.threshold = t.priority;
+		taskset[n_tasks++] = t;
+	}
+	fclose(f);
+	return n_tasks > 0 ? 0 : -1;
+}
+
+/* ======================== Analysis ====================================================== */
+/**
+ * @brief Response time analysis of the task set with the kernel's src/rta.c (same test as admission control).
+ */
+static void response_time_analysis(uint64_t overhead_us)
+{
+	rta_task_t set[SIM_MAX_TASKS];
+	for (uint32_t i = 0; i < n_tasks; i++) {
+		set[i] = (rta_task_t){ .period_us = taskset[i].period_us, .wcet_us = taskset[i].wcet_us,
+				.deadline_us = taskset[i].deadline_us, .priority = taskset[i].priority,
+				.threshold = taskset[i].threshold };
+	}
+	rta_response_times(set, n_tasks, overhead_us);
+	for (uint32_t i = 0; i < n_tasks; i++)
+		taskset[i].rta_us = set[i].response_us;
+}
+
+/**
+ * @brief Replace priorities of the task set with rate-monotonic ones, as CONFIG_ADMISSION_CONTROL assigns them.
+ */
+static int assign_rate_monotonic(void)
+{
+	rta_task_t set[SIM_MAX_TASKS];
+	for (uint32_t i = 0; i < n_tasks; i++)
+		set[i] = (rta_task_t){ .period_us = taskset[i].period_us };
+	if (rta_assign_rate_monotonic(set, n_tasks, CONFIG_RM_TOP_PRIORITY) != 0)
+		return -1;
+	for (uint32_t i = 0; i < n_tasks; i++)
+		taskset[i].priority = taskset[i].threshold = set[i].priority;
+	return 0;
+}
+
+static uint64_t gcd(uint64_t a, uint64_t b)
+{
+	while (b != 0) {
+		uint64_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+static uint64_t hyperperiod_us(void)
+{
+	uint64_t h = 1;
+	for (uint32_t i = 0; i < n_tasks; i++) {
+		h = h / gcd(h, taskset[i].period_us) * taskset[i].period_us;
+		if (h > 3600ULL * 1000000ULL)
+			return 0; // too long to be useful
+	}
+	return h;
+}
+
+static int32_t task_threshold(uint32_t i, uint32_t use_thresholds)
+{
+	return use_thresholds ? taskset[i].threshold : taskset[i].priority;
+}
+
+/**
+ * @brief Worst-case stack of run-to-completion jobs sharing one stack: the deepest chain of jobs preempting
+ *        each other (j preempts i only if priority of j is above threshold of i, so chains go up in priority).
+ */
+static uint64_t shared_stack_bytes(uint32_t use_thresholds)
+{
+	uint64_t depth[SIM_MAX_TASKS], worst = 0;
+	uint32_t order[SIM_MAX_TASKS];
+	for (uint32_t i = 0; i < n_tasks; i++) {
+		uint32_t k = i;
+		for (; k > 0 && taskset[order[k - 1]].priority > taskset[i].priority; k--)
+			order[k] = order[k - 1];
+		order[k] = i;
+	}
+	for (uint32_t k = 0; k < n_tasks; k++) {
+		uint32_t i = order[k];
+		uint64_t below = 0;
+		for (uint32_t m = 0; m < k; m++) {
+			uint32_t j = order[m];
+			if (taskset[i].priority > task_threshold(j, use_thresholds) && depth[j] > below)
+				below = depth[j];
+		}
+		depth[i] = below + taskset[i].stack_bytes;
+		if (depth[i] > worst)
+			worst = depth[i];
+	}
+	return worst;
+}
+
+static uint32_t has_thresholds(void)
+{
+	for (uint32_t i = 0; i < n_tasks; i++) {
+		if (taskset[i].threshold > taskset[i].priority)
+			return 1;
+	}
+	return 0;
+}
+
+/* ======================== Cyclic executive table ======================================== */
+#define CYCLIC_MAX_FRAMES (8192U)
+
+/**
+ * @brief Cut the hyperperiod into minor frames and give each frame to the ready job with the earliest deadline.
+ *        A job runs from the start of its frame, so a frame serves at most frame_us of one job and the rest of
+ *        the frame is idle. Writes C header with the table and prints per-task summary.
+ * @return 0 on success, -1 if the task set can't be scheduled with this frame.
+ */
+static int generate_cyclic_table(const char *out_path, const char *taskset_path, uint64_t frame_us)
+{
+	static int32_t owner[CYCLIC_MAX_FRAMES];
+	static uint8_t flags[CYCLIC_MAX_FRAMES];
+	uint64_t next_release[SIM_MAX_TASKS] = {0}, abs_deadline[SIM_MAX_TASKS] = {0};
+	uint32_t started[SIM_MAX_TASKS] = {0}, frames_used[SIM_MAX_TASKS] = {0};
+	uint64_t h = hyperperiod_us();
+
+	if (frame_us == 0 || h == 0 || h % frame_us != 0 || h / frame_us > CYCLIC_MAX_FRAMES) {
+		fprintf(stderr, "Hyperperiod %llu us must be a multiple of the frame and have at most %u frames\n",
+				(unsigned long long)h, CYCLIC_MAX_FRAMES);
+		return -1;
+	}
+	uint32_t n_frames = h / frame_us;
+	for (uint32_t i = 0; i < n_tasks; i++)
+		taskset[i].remaining_us = 0;
+
+	for (uint32_t k = 0; k < n_frames; k++) {
+		uint64_t t0 = (uint64_t)k * frame_us;
+		int32_t best = -1;
+		for (uint32_t i = 0; i < n_tasks; i++) {
+			sim_task_t *t = &taskset[i];
+			if (next_release[i] <= t0) {
+				if (t->remaining_us != 0) {
+					fprintf(stderr, "%s: job released at %llu us is not done by the next release\n", t->name,
+							(unsigned long long)t->release_us);
+					return -1;
+				}
+				t->release_us = next_release[i];
+				t->remaining_us = t->wcet_us;
+				abs_deadline[i] = next_release[i] + t->deadline_us;
+				started[i] = 0;
+				next_release[i] += t->period_us;
+			}
+			if (t->remaining_us != 0 && (best < 0 || abs_deadline[i] < abs_deadline[best] ||
+					(abs_deadline[i] == abs_deadline[best] && t->priority > taskset[best].priority)))
+				best = i;
+		}
+		owner[k] = best;
+		flags[k] = 0;
+		if (best < 0)
+			continue;
+
+		sim_task_t *t = &taskset[best];
+		uint64_t run = (t->remaining_us < frame_us) ? t->remaining_us : frame_us;
+		if (!started[best])
+			flags[k] |= 1;	// CYCLIC_JOB_START
+		started[best] = 1;
+		frames_used[best]++;
+		t->remaining_us -= run;
+		if (t->remaining_us == 0) {
+			flags[k] |= 2;	// CYCLIC_JOB_END
+			uint64_t response = t0 + run - t->release_us;
+			if (t0 + run > abs_deadline[best]) {
+				fprintf(stderr, "%s: job released at %llu us misses its deadline with %llu us frames\n", t->name,
+						(unsigned long long)t->release_us, (unsigned long long)frame_us);
+				return -1;
+			}
+			if (response > t->worst_response_us)
+				t->worst_response_us = response;
+		}
+	}
+	for (uint32_t i = 0; i < n_tasks; i++) {
+		if (taskset[i].remaining_us != 0) {
+			fprintf(stderr, "%s: job crosses the hyperperiod end\n", taskset[i].name);
+			return -1;
+		}
+	}
+
+	FILE *f = fopen(out_path, "w");
+	if (f == NULL) {
+		perror(out_path);
+		return -1;
+	}
+	fprintf(f, "/* Generated by tools/sched_sim from %s, do not edit. */\n", taskset_path);
+	fprintf(f, "#ifndef CYCLIC_TABLE_H_\n#define CYCLIC_TABLE_H_\n\n");
+	fprintf(f, "#define CYCLIC_FRAME_US (%lluU)\n", (unsigned long long)frame_us);
+	fprintf(f, "#define CYCLIC_FRAMES (%uU)\n\n", n_frames);
+	fprintf(f, "static const cyclic_frame_t cyclic_table[CYCLIC_FRAMES] = {\n");
+	for (uint32_t k = 0; k < n_frames; k++) {
+		const char *start = (flags[k] & 1) ? "CYCLIC_JOB_START" : "0";
+		const char *end = (flags[k] & 2) ? " | CYCLIC_JOB_END" : "";
+		if (owner[k] < 0)
+			fprintf(f, "\t{ IDLE_TASK_ID, 0 },\n");
+		else
+			fprintf(f, "\t{ %s_id, %s%s },\n", taskset[owner[k]].name, start, end);
+	}
+	fprintf(f, "};\n\n#endif /* CYCLIC_TABLE_H_ */\n");
+	fclose(f);
+
+	uint32_t idle_frames = 0;
+	for (uint32_t k = 0; k < n_frames; k++)
+		idle_frames += (owner[k] < 0);
+	printf("Cyclic table: %u frames of %llu us (hyperperiod %llu us), %u idle frames, %u bytes\n", n_frames,
+			(unsigned long long)frame_us, (unsigned long long)h, idle_frames,
+			n_frames * (uint32_t)sizeof(uint16_t));
+	printf("%-16s %10s %10s %12s %14s\n", "task", "period_us", "wcet_us", "frames_used", "worst_resp_us");
+	for (uint32_t i = 0; i < n_tasks; i++)
+		printf("%-16s %10llu %10llu %12u %14llu\n", taskset[i].name, (unsigned long long)taskset[i].period_us,
+				(unsigned long long)taskset[i].wcet_us, frames_used[i],
+				(unsigned long long)taskset[i].worst_response_us);
+	return 0;
+}
+
+/* ======================== Simulation ==================================================== */
+static uint64_t sim_now_us = 0;
+static uint64_t context_switches = 0;
+static uint64_t pendsv_runs = 0;
+static uint64_t idle_us = 0;
+static uint64_t overhead_total_us = 0;
+static uint32_t preemptions_avoided = 0;
+static uint32_t tick_base = 0;			// kernel tick at the start of the simulation run
+static uint64_t wakeup_ticks = 0;		// ticks which released at least one task
+static uint32_t merged_wakeups = 0;
+static uint32_t slack_percent = 0;
+
+static sim_task_t *task_of(uint32_t task_id)
+{
+	if (task_id < SIM_FIRST_TASK_ID || task_id >= SIM_FIRST_TASK_ID + n_tasks)
+		return NULL;
+	return &taskset[task_id - SIM_FIRST_TASK_ID];
+}
+
+/* What PendSV_Handler does: select next task */
+static void run_pendsv(uint64_t overhead_us)
+{
+	uint32_t prev = current_task;
+	switch_pending = 0;
+	pendsv_runs++;
+	update_to_next_task();
+	if (current_task != prev) {
+		context_switches++;
+		overhead_total_us += overhead_us;
+		sim_now_us += overhead_us;
+	}
+}
+
+/* Job of the current task is finished: account it, then block till the next release like delay_task loop does */
+static void complete_job(sim_task_t *t, uint64_t tick_us)
+{
+	uint64_t response = sim_now_us - t->release_us;
+	t->jobs++;
+	if (response > t->worst_response_us)
+		t->worst_response_us = response;
+	if (response > t->deadline_us)
+		t->misses++;
+
+	t->release_us += t->period_us;
+	t->remaining_us = t->wcet_us;
+	if (t->release_us > sim_now_us) {
+		// Kernel wakes tasks on ticks only, so the job starts on the first tick after its release:
+		uint64_t wake_tick = (t->release_us + tick_us - 1) / tick_us;
+		uint32_t slack = (uint32_t)(t->period_us * slack_percent / 100 / tick_us);
+		// Response times still count from the nominal release, so the delay added by slack is visible:
+		delay_task_slack((uint32_t)(wake_tick + tick_base - get_tick_count()), slack);
+	}
+	// else: the task is late, it continues with the next job without blocking
+}
+
+static void simulate(uint64_t duration_us, uint64_t overhead_us, uint32_t use_thresholds)
+{
+	const uint64_t tick_us = 1000000ULL / CONFIG_TICK_RATE_HZ;
+	uint64_t next_tick_us = tick_us;
+
+	sim_now_us = 0;
+	context_switches = 0;
+	pendsv_runs = 0;
+	idle_us = 0;
+	overhead_total_us = 0;
+	for (uint32_t i = 0; i < n_tasks; i++) {
+		taskset[i].release_us = 0;
+		taskset[i].remaining_us = taskset[i].wcet_us;
+		taskset[i].busy_us = 0;
+		taskset[i].worst_response_us = 0;
+		taskset[i].jobs = 0;
+		taskset[i].misses = 0;
+	}
+
+	init_and_run_scheduler();
+	tick_base = get_tick_count();
+	// Park placeholder tasks which are not part of the task set:
+	for (uint32_t id = SIM_FIRST_TASK_ID + n_tasks; id < SIM_FIRST_TASK_ID + SIM_MAX_TASKS; id++) {
+		current_task = id;
+		task_wait_notify(WAIT_FOREVER);
+	}
+	for (uint32_t i = 0; i < n_tasks; i++)
+		task_set_priority(SIM_FIRST_TASK_ID + i, taskset[i].priority, task_threshold(i, use_thresholds));
+	current_task = SIM_FIRST_TASK_ID;
+	switch_pending = 0;
+	uint32_t avoided_start = get_preemptions_avoided_count();
+	uint32_t merged_start = get_merged_wakeup_count();
+	wakeup_ticks = 0;
+
+	while (sim_now_us < duration_us) {
+		sim_task_t *t = task_of(current_task);
+		uint64_t run_until = next_tick_us;
+		if (t != NULL && sim_now_us + t->remaining_us < run_until)
+			run_until = sim_now_us + t->remaining_us;
+
+		if (run_until > sim_now_us) {
+			if (t != NULL) {
+				t->remaining_us -= run_until - sim_now_us;
+				t->busy_us += run_until - sim_now_us;
+			} else {
+				idle_us += run_until - sim_now_us;
+			}
+			sim_now_us = run_until;
+		}
+
+		if (t != NULL && t->remaining_us == 0) {
+			complete_job(t, tick_us);
+			if (switch_pending)
+				run_pendsv(overhead_us);
+		}
+
+		if (sim_now_us >= next_tick_us) {
+			// SysTick_Handler:
+			update_global_tick_count();
+			uint32_t released = update_blocked_tasks();
+			wakeup_ticks += (released != 0);
+			if (released || is_time_slice_due())
+				schedule();
+			next_tick_us += tick_us;
+			if (switch_pending)
+				run_pendsv(overhead_us);
+		}
+	}
+	preemptions_avoided = get_preemptions_avoided_count() - avoided_start;
+	merged_wakeups = get_merged_wakeup_count() - merged_start;
+}
+
+/* ======================== Report ======================================================== */
+static void print_report(uint64_t duration_us, uint64_t overhead_us, uint64_t full_preemption_switches,
+		uint32_t full_preemption_misses)
+{
+	double utilization = 0;
+	uint32_t schedulable = 1, misses = 0;
+	for (uint32_t i = 0; i < n_tasks; i++)
+		utilization += (double)taskset[i].wcet_us / taskset[i].period_us;
+	double ll_bound = n_tasks * (pow(2.0, 1.0 / n_tasks) - 1);
+
+	printf("Tasks: %u, tick: %u Hz, switch overhead: %llu us, simulated: %.3f s\n", n_tasks,
+			CONFIG_TICK_RATE_HZ, (unsigned long long)overhead_us, duration_us / 1e6);
+	printf("Utilization: %.4f (Liu-Layland bound for RM: %.4f)\n\n", utilization, ll_bound);
+	printf("%-16s %10s %10s %10s %5s %5s %7s %12s %12s %6s %6s\n", "task", "period_us", "wcet_us", "deadl_us",
+			"prio", "thr", "util", "rta_resp_us", "sim_wc_us", "jobs", "miss");
+	for (uint32_t i = 0; i < n_tasks; i++) {
+		sim_task_t *t = &taskset[i];
+		char rta[24];
+		if (t->rta_us)
+			snprintf(rta, sizeof(rta), "%llu", (unsigned long long)t->rta_us);
+		else
+			snprintf(rta, sizeof(rta), "MISS");
+		printf("%-16s %10llu %10llu %10llu %5d %5d %7.4f %12s %12llu %6u %6u\n", t->name,
+				(unsigned long long)t->period_us, (unsigned long long)t->wcet_us,
+				(unsigned long long)t->deadline_us, t->priority, t->threshold,
+				(double)t->wcet_us / t->period_us, rta,
+				(unsigned long long)t->worst_response_us, t->jobs, t->misses);
+		schedulable &= (t->rta_us != 0);
+		misses += t->misses;
+	}
+	printf("\nResponse-time analysis (fixed-priority preemptive): %s\n",
+			schedulable ? "all deadlines met" : "deadlines can be missed");
+	printf("Simulation (kernel policy %s): %s\n",
+			(CONFIG_SCHED_POLICY == SCHED_POLICY_PRIORITY) ? "priority" : "round-robin",
+			misses ? "deadline misses observed" : "no deadline misses");
+	printf("Context switches: %llu (%.1f / s), PendSV runs: %llu (%.1f / s)\n",
+			(unsigned long long)context_switches, context_switches / (duration_us / 1e6),
+			(unsigned long long)pendsv_runs, pendsv_runs / (duration_us / 1e6));
+	printf("Idle capacity: %.2f %%, switch overhead: %.2f %%\n", 100.0 * idle_us / sim_now_us,
+			100.0 * overhead_total_us / sim_now_us);
+	printf("Wakeup ticks: %llu (%.1f / s), slack: %u %% of period, merged wakeups: %u\n",
+			(unsigned long long)wakeup_ticks, wakeup_ticks / (duration_us / 1e6), slack_percent, merged_wakeups);
+
+	if (has_thresholds()) {
+		uint64_t separate = 0;
+		for (uint32_t i = 0; i < n_tasks; i++)
+			separate += taskset[i].stack_bytes;
+		uint64_t shared_full = shared_stack_bytes(0), shared_thr = shared_stack_bytes(1);
+		printf("\nPreemption thresholds:\n");
+		printf("Context switches: %llu with full preemption, %llu with thresholds (%lld avoided), "
+				"deferred preemptions: %u\n", (unsigned long long)full_preemption_switches,
+				(unsigned long long)context_switches, (long long)(full_preemption_switches - context_switches),
+				preemptions_avoided);
+		printf("Deadline misses: %u with full preemption, %u with thresholds\n", full_preemption_misses, misses);
+		printf("Stack: %llu B in separate stacks, shared stack of run-to-completion jobs: %llu B with full "
+				"preemption, %llu B with thresholds (%llu B saved)\n", (unsigned long long)separate,
+				(unsigned long long)shared_full, (unsigned long long)shared_thr,
+				(unsigned long long)(separate - shared_thr));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	uint64_t duration_us = 0, overhead_us = 0, frame_us = 0;
+	const char *path = NULL, *table_path = NULL;
+	uint32_t rate_monotonic = 0;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+			duration_us = (uint64_t)(atof(argv[++i]) * 1e6);
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			overhead_us = strtoull(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+			slack_percent = strtoul(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc)
+			table_path = argv[++i];
+		else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+			frame_us = strtoull(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "-m") == 0)
+			rate_monotonic = 1;
+		else
+			path = argv[i];
+	}
+	if (path == NULL) {
+		fprintf(stderr, "Usage: %s [-d duration_s] [-o switch_overhead_us] [-s slack_percent] [-m] <taskset file>\n"
+				"       %s -g <cyclic_table.h> -f <frame_us> <taskset file>\n", argv[0], argv[0]);
+		return 2;
+	}
+	if (load_taskset(path) != 0)
+		return 2;
+	if (table_path != NULL)
+		return generate_cyclic_table(table_path, path, frame_us) == 0 ? 0 : 1;
+
+	if (duration_us == 0) {
+		// Two hyperperiods (first one includes the critical instant), limited to 60 s
+		duration_us = 2 * hyperperiod_us();
+		if (duration_us == 0 || duration_us > 60ULL * 1000000ULL)
+			duration_us = 60ULL * 1000000ULL;
+	}
+
+	if (rate_monotonic && assign_rate_monotonic() != 0) {
+		fprintf(stderr, "More distinct periods than priorities up to CONFIG_RM_TOP_PRIORITY\n");
+		return 2;
+	}
+	response_time_analysis(overhead_us);
+	uint64_t full_preemption_switches = 0;
+	uint32_t full_preemption_misses = 0;
+	if (has_thresholds()) {
+		simulate(duration_us, overhead_us, 0);
+		full_preemption_switches = context_switches;
+		for (uint32_t i = 0; i < n_tasks; i++)
+			full_preemption_misses += taskset[i].misses;
+	}
+	simulate(duration_us, overhead_us, 1);
+	print_report(duration_us, overhead_us, full_preemption_switches, full_preemption_misses);
+	return 0;
+}
@@ -0,0 +1,32 @@
+/*
+ * sim_config.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: konstantin
+ *
+ * Kernel configuration of the host simulator, force-included before kernel headers (-include).
+ * The kernel is built with SIM_MAX_TASKS placeholder user tasks, slots not used by the task set are
+ * suspended at start.
+ */
+
+#ifndef SIM_CONFIG_H_
+#define SIM_CONFIG_H_
+
+#define KERNEL_CONFIG_MINIMAL
+#define CONFIG_STATS 1
+#ifndef CONFIG_SCHED_POLICY
+#define CONFIG_SCHED_POLICY SCHED_POLICY_PRIORITY	// task set priorities are used, override with SIM_CFLAGS
+#endif
+
+#define SIM_MAX_TASKS (16)
+
+#define CONFIG_USER_TASKS(X) \
+	X(sim_task_0, 256) X(sim_task_1, 256) X(sim_task_2, 256) X(sim_task_3, 256) \
+	X(sim_task_4, 256) X(sim_task_5, 256) X(sim_task_6, 256) X(sim_task_7, 256) \
+	X(sim_task_8, 256) X(sim_task_9, 256) X(sim_task_10, 256) X(sim_task_11, 256) \
+	X(sim_task_12, 256) X(sim_task_13, 256) X(sim_task_14, 256) X(sim_task_15, 256)
+
+#define SIM_TASK_DECLARE(entry, stack_size, ...) void entry(void);
+CONFIG_USER_TASKS(SIM_TASK_DECLARE)
+
+#endif /* SIM_CONFIG_H_ */
@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+"""
+Worst-case stack usage of every task and of the exception handlers, from the call graph GCC writes with
+-fstack-usage -fcallgraph-info=su (one .ci file per object). Writes a header with the stack sizes the build uses:
+
+    python3 tools/stack_usage/stack_usage.py -r tools/stack_usage/stack_rules.txt -t "task_idle task_1_handler" \\
+        -o build/gen/stack_sizes.h build/stack/src/*.ci build/stack/port/*.ci
+
+Task stack = deepest call path from the task entry + exception frame and R4-R11 (PendSV) saved on the task stack
++ stack canary word. Handler (MSP) stack = deepest path of any interrupt handler + exception frame + deepest path of
+a fault handler: a fault taken inside an ISR escalates and its handler runs on top of the ISR (all interrupts have
+the same priority, so they don't nest otherwise).
+Fails on recursion, dynamic stack allocation and calls without stack usage information (function pointers,
+inline assembly, libraries) which are not described in the rules file. "indirect" budgets of function pointer calls
+are assumptions: the callbacks really passed are not checked against them, the report lists the ones used.
+"""
+import argparse
+import re
+import sys
+
+INDIRECT = '__indirect_call'
+FAULT_HANDLER_RE = re.compile(r'^(HardFault|MemManage|BusFault|UsageFault)_Handler$')
+CONTEXT_SAVE_B = 8 * 4          # R4-R11 pushed by PendSV_Handler
+CANARY_B = 4                    # STACK_CANARY word at the stack limit (CONFIG_STACK_CHECK)
+STACK_ALIGN_B = 8
+
+NODE_RE = re.compile(r'node: \{ title: "([^"]+)" label: "([^"]*)"')
+EDGE_RE = re.compile(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+SIZE_RE = re.compile(r'\\n(\d+) bytes \(([a-z,]+)\)')
+
+
+class StackError(Exception):
+    pass
+
+
+class CallGraph:
+    def __init__(self):
+        self.frame = {}         # function -> own stack bytes
+        self.dynamic = set()    # functions with unbounded dynamic stack allocation
+        self.calls = {}         # function -> set of callees
+        self.rule_frame = {}
+        self.rule_calls = {}
+        self.indirect_budget = {}
+        self.indirect_used = {}  # function -> "indirect" budget some worst path relies on
+
+    def load_ci(self, path):
+        with open(path) as f:
+            for line in f:
+                node = NODE_RE.match(line)
+                if node:
+                    title, label = node.groups()
+                    size = SIZE_RE.search(label)
+                    if size:    # declarations of functions from other objects have no size
+                        self.frame[title] = int(size.group(1))
+                        if 'dynamic' in size.group(2) and 'bounded' not in size.group(2):
+                            self.dynamic.add(title)
+                    continue
+                edge = EDGE_RE.match(line)
+                if edge:
+                    self.calls.setdefault(edge.group(1), set()).add(edge.group(2))
+
+    def load_rules(self, path):
+        with open(path) as f:
+            for n, line in enumerate(f, 1):
+                words = line.split('#', 1)[0].split()
+                if not words:
+                    continue
+                try:
+                    if words[0] == 'call' and len(words) >= 3:
+                        self.rule_calls.setdefault(words[1], set()).update(words[2:])
+                    elif words[0] == 'frame' and len(words) == 3:
+                        self.rule_frame[words[1]] = int(words[2], 0)
+                    elif words[0] == 'indirect' and len(words) == 3:
+                        self.indirect_budget[words[1]] = int(words[2], 0)
+                    else:
+                        raise ValueError
+                except ValueError:
+                    sys.exit('%s:%d: bad rule "%s"' % (path, n, line.strip()))
+
+    @staticmethod
+    def short(title):
+        # Static functions are "file.c:name", rules and reports use the plain name:
+        return title.rsplit(':', 1)[-1]
+
+    def rule(self, table, title):
+        return table.get(title, table.get(self.short(title)))
+
+    def callees(self, title):
+        callees = set(self.calls.get(title, ()))
+        extra = self.rule(self.rule_calls, title) or ()
+        # Assembly calls to functions which are not linked in this configuration can't be executed:
+        callees.update(c for c in extra if c in self.frame or c in self.rule_frame)
+        return callees
+
+    def own_frame(self, title):
+        if title in self.dynamic:
+            raise StackError('%s allocates stack dynamically (alloca or variable length array)' % title)
+        frame, rule = self.frame.get(title), self.rule(self.rule_frame, title)
+        if frame is None and rule is None:
+            raise StackError('no stack usage for %s, add a "frame" rule' % title)
+        return max(frame or 0, rule or 0)
+
+    def worst_path(self, root):
+        """Deepest stack use from "root": (bytes, call path)."""
+        memo = {}
+        active = []
+
+        def visit(title):
+            if title in active:
+                cycle = active[active.index(title):] + [title]
+                raise StackError('recursion: ' + ' -> '.join(self.short(t) for t in cycle))
+            if title in memo:
+                return memo[title]
+            active.append(title)
+            best = (0, [])
+            for callee in sorted(self.callees(title)):
+                if callee == INDIRECT:
+                    budget = self.rule(self.indirect_budget, title)
+                    if budget is None:
+                        raise StackError('function pointer call in %s, add an "indirect" or "call" rule'
+                                         % self.short(title))
+                    self.indirect_used[self.short(title)] = budget
+                    sub = (budget, ['(indirect)'])
+                else:
+                    sub = visit(callee)
+                if sub[0] > best[0]:
+                    best = sub
+            active.pop()
+            memo[title] = (self.own_frame(title) + best[0], [self.short(title)] + best[1])
+            return memo[title]
+
+        if root not in self.frame and root not in self.rule_frame:
+            raise StackError('%s is not in the call graph' % root)
+        return visit(root)
+
+
+def align(size):
+    return (size + STACK_ALIGN_B - 1) // STACK_ALIGN_B * STACK_ALIGN_B
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('ci', nargs='+', help='.ci files of all objects of the image')
+    parser.add_argument('-t', '--tasks', required=True, help='task entry functions (KERNEL_TASK_LIST order)')
+    parser.add_argument('-r', '--rules', help='calls and stack usage the compiler does not know')
+    parser.add_argument('-o', '--output', required=True, help='generated header')
+    parser.add_argument('-f', '--exception-frame', type=int, default=32,
+                        help='bytes stacked on exception entry: 32, or 104 with FPU context (default 32)')
+    parser.add_argument('-m', '--margin', type=int, default=0, help='extra bytes added to every stack')
+    args = parser.parse_args()
+
+    graph = CallGraph()
+    for path in args.ci:
+        graph.load_ci(path)
+    if args.rules:
+        graph.load_rules(args.rules)
+
+    # Exception entry aligns SP to 8 bytes and may push one padding word:
+    exc_frame = args.exception_frame + 4
+    handlers = sorted(t for t in graph.frame if re.search(r'_(IRQ)?Handler$', t) and t != 'Reset_Handler')
+    lines = []
+    errors = []
+    print('%-28s %6s %6s  %s' % ('stack', 'path_B', 'size_B', 'worst path'))
+    for task in args.tasks.split():
+        try:
+            depth, path = graph.worst_path(task)
+        except StackError as e:
+            errors.append('%s: %s' % (task, e))
+            continue
+        size = align(depth + exc_frame + CONTEXT_SAVE_B + CANARY_B + args.margin)
+        lines.append('#define STACK_SIZE_%s (%dU)' % (task, size))
+        print('%-28s %6d %6d  %s' % (task, depth, size, ' -> '.join(path)))
+
+    worst_isr, worst_fault = (0, []), (0, [])
+    for handler in handlers:
+        try:
+            if FAULT_HANDLER_RE.match(handler):
+                worst_fault = max(worst_fault, graph.worst_path(handler))
+            else:
+                worst_isr = max(worst_isr, graph.worst_path(handler))
+        except StackError as e:
+            errors.append('%s: %s' % (handler, e))
+    # Fault in the deepest ISR: its exception frame and the fault handler go on top of the ISR stack
+    depth = worst_isr[0] + exc_frame + worst_fault[0]
+    size = align(depth + args.margin)
+    lines.append('#define STACK_SIZE_HANDLERS (%dU)' % size)
+    print('%-28s %6d %6d  %s + (fault) %s' % ('handlers (MSP)', depth, size, ' -> '.join(worst_isr[1]),
+                                             ' -> '.join(worst_fault[1])))
+
+    # Function pointer calls are sized by their rules only, nothing checks the callbacks against them:
+    assumptions = ['%s: callbacks use at most %d B of stack ("indirect" rule)' % item
+                   for item in sorted(graph.indirect_used.items())]
+    for line in assumptions:
+        print('assumed, not checked: ' + line)
+
+    if errors:
+        sys.exit('stack analysis failed:\n  ' + '\n  '.join(errors))
+
+    with open(args.output, 'w') as f:
+        f.write('/* Generated by tools/stack_usage/stack_usage.py from the call graph, don\'t edit. */\n')
+        f.write('#ifndef STACK_SIZES_H_\n#define STACK_SIZES_H_\n\n')
+        if assumptions:
+            f.write('/* Sizes assume, not checked:\n * ' + '\n * '.join(assumptions) + '\n */\n')
+        f.write('\n'.join(lines))
+        f.write('\n\n#endif /* STACK_SIZES_H_ */\n')
+
+
+if __name__ == '__main__':
+    main()